@@ -0,0 +1,539 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    // Exception thrown when an archive cannot be written or read
+    class bad_archive : public std::exception {
+    public:
+        explicit bad_archive(const char* message) noexcept
+            : m_message(message) {}
+
+        const char* what() const noexcept override {
+            return m_message;
+        }
+    private:
+        const char* m_message {};
+    };
+
+    namespace internal {
+        // A type is serializable, if it exposes its state through the member function
+        //     template<typename Archive>
+        //     void serialize(Archive& archive);
+        // which calls archive(member) for every member; the same function is used for both writing and reading, and
+        // it must not modify the object when writing
+        // Arithmetic types, enums, strings, vectors, shared_refs and weak_refs are serializable out of the box
+
+        struct ProbeArchive {
+            template<typename... Ts>
+            void operator()(Ts&...) const noexcept {}
+        };
+
+        template<typename T, typename = void>
+        struct is_serializable : std::false_type {};
+
+        template<typename T>
+        struct is_serializable<T, std::void_t<
+            decltype(std::declval<T&>().serialize(std::declval<ProbeArchive&>()))
+        >> : std::true_type {};
+
+        template<typename T>
+        inline constexpr bool is_serializable_v {is_serializable<std::remove_cv_t<T>>::value};
+
+        template<typename T>
+        inline constexpr bool is_archived_raw_v {std::is_arithmetic_v<T> || std::is_enum_v<T>};
+
+        // Written in native byte order; reading it back swapped means the archive comes from a different machine
+        inline constexpr std::uint32_t ARCHIVE_MAGIC {0x52414D53};
+        inline constexpr std::uint32_t ARCHIVE_MAGIC_SWAPPED {0x534D4152};
+        inline constexpr std::uint32_t ARCHIVE_VERSION {1};
+
+        // The writer goes through a buffer of this size and the reader grows strings and vectors by chunks of it,
+        // so memory use doesn't depend on the size of the archive, apart from the table of objects
+        inline constexpr std::size_t ARCHIVE_BUFFER_SIZE {64 * 1024};
+
+        // A reference is written as a tag: null, a new object that follows right after, or a back-reference to an
+        // object written before, numbered in the order of first appearance
+        inline constexpr std::uint64_t ARCHIVE_REF_NULL {0};
+        inline constexpr std::uint64_t ARCHIVE_REF_NEW {1};
+        inline constexpr std::uint64_t ARCHIVE_REF_FIRST_INDEX {2};
+
+        // Open addressing table from the identities of the written objects to their indices
+        // Every written reference is looked up, so this avoids the node allocations of std::unordered_map
+        class ArchiveTable {
+        public:
+            // Find the index of the key, or give it the next index; return whether it was inserted
+            std::pair<std::uint64_t, bool> insert(const void* key) {
+                if ((m_size + 1) * 4 > m_slots.size() * 3) {
+                    grow();
+                }
+
+                Slot& slot {find(key)};
+
+                if (slot.key == key) {
+                    return std::make_pair(slot.index, false);
+                }
+
+                slot.key = key;
+                slot.index = m_size++;
+
+                return std::make_pair(slot.index, true);
+            }
+
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+        private:
+            struct Slot {
+                const void* key {nullptr};
+                std::uint64_t index {};
+            };
+
+            Slot& find(const void* key) noexcept {
+                const std::size_t mask {m_slots.size() - 1};
+                std::size_t i {hash(key)};
+
+                while (m_slots[i].key != nullptr && m_slots[i].key != key) {
+                    i = (i + 1) & mask;
+                }
+
+                return m_slots[i];
+            }
+
+            // Fibonacci hashing, taking the top bits, as the low bits of addresses are mostly zero
+            std::size_t hash(const void* key) const noexcept {
+                const auto value {static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key))};
+
+                return static_cast<std::size_t>((value * 0x9E3779B97F4A7C15) >> m_shift);
+            }
+
+            void grow() {
+                std::vector<Slot> slots(m_slots.empty() ? 1024 : m_slots.size() * 2);
+                slots.swap(m_slots);
+                m_shift = m_slots.size() == 1024 ? 54 : m_shift - 1;
+
+                for (const Slot& slot : slots) {
+                    if (slot.key != nullptr) {
+                        find(slot.key) = slot;
+                    }
+                }
+            }
+
+            std::vector<Slot> m_slots;
+            std::size_t m_size {0};
+            unsigned int m_shift {64};
+        };
+    }
+
+    // Writer of objects to a binary stream
+    // Every object managed by shared_refs is written only once, no matter how many references to it are written;
+    // its control block identifies it, so references to a part of an object, made with the aliasing constructor,
+    // are not supported
+    // The static type of the references is what gets written, so polymorphic objects are sliced
+    // Objects are written recursively, so the depth of a graph is limited by the stack
+    // The archive is complete only once finish is called; whatever is still buffered when the writer is destroyed
+    // without it is discarded, as the destructor could not report a failing stream
+    class archive_writer {
+    public:
+        explicit archive_writer(std::ostream& stream)
+            : m_stream(stream) {
+            m_buffer.reserve(internal::ARCHIVE_BUFFER_SIZE);
+
+            write(internal::ARCHIVE_MAGIC);
+            write(internal::ARCHIVE_VERSION);
+        }
+
+        ~archive_writer() noexcept = default;
+
+        archive_writer(const archive_writer&) = delete;
+        archive_writer& operator=(const archive_writer&) = delete;
+        archive_writer(archive_writer&&) = delete;
+        archive_writer& operator=(archive_writer&&) = delete;
+
+        // Write the values in order
+        template<typename... Ts>
+        void operator()(const Ts&... values) {
+            (write(values), ...);
+        }
+
+        // Write everything buffered to the stream and flush it
+        void flush() {
+            flush_buffer();
+            m_stream.flush();
+
+            if (!m_stream) {
+                throw bad_archive("Could not write the archive to the stream");
+            }
+        }
+
+        // Complete the archive, writing everything buffered to the stream and flushing it
+        // Throw an exception, if the stream fails
+        void finish() {
+            flush();
+        }
+
+        // Get the number of distinct objects managed by shared_refs written so far
+        std::size_t objects() const noexcept {
+            return m_objects.size();
+        }
+    private:
+        // Objects are identified by their control blocks, which are kept allocated by a weak reference, so that no
+        // other block can take the address of a written one while the writer is alive
+        struct Object {
+            const void* ptr {};
+            internal::WeakBlock block;
+        };
+
+        template<typename T>
+        void write(const T& value) {
+            if constexpr (internal::is_archived_raw_v<T>) {
+                write_bytes(&value, sizeof(T));
+            } else {
+                static_assert(internal::is_serializable_v<T>, "Type must be serializable");
+
+                // Serialization functions are used for reading too, so they are not const
+                const_cast<T&>(value).serialize(*this);
+            }
+        }
+
+        template<typename Char, typename Traits, typename Alloc>
+        void write(const std::basic_string<Char, Traits, Alloc>& string) {
+            write_varint(string.size());
+            write_bytes(string.data(), string.size() * sizeof(Char));
+        }
+
+        template<typename T, typename Alloc>
+        void write(const std::vector<T, Alloc>& vector) {
+            write_varint(vector.size());
+
+            if constexpr (internal::is_archived_raw_v<T> && !std::is_same_v<T, bool>) {
+                write_bytes(vector.data(), vector.size() * sizeof(T));
+            } else {
+                for (const auto& element : vector) {
+                    write(static_cast<const T&>(element));
+                }
+            }
+        }
+
+        template<typename T>
+        void write(const shared_ref<T>& ref) {
+            write_ref(ref.get(), internal::RefAccess::block(ref));
+        }
+
+        // A weak_ref is written like a shared_ref to its object, if it has not expired
+        template<typename T>
+        void write(const weak_ref<T>& ref) {
+            const shared_ref<T> locked {ref.lock()};
+            write(locked);
+        }
+
+        template<typename T>
+        void write_ref(T* ptr, const internal::ControlBlock& block) {
+            if (ptr == nullptr) {
+                write_varint(internal::ARCHIVE_REF_NULL);
+                return;
+            }
+
+            // Immortal objects share one block, but they don't move either
+            const void* key {block && !block.immortal() ? block.base() : static_cast<const void*>(ptr)};
+            const auto result {m_table.insert(key)};
+
+            if (!result.second) {
+                if (m_objects[static_cast<std::size_t>(result.first)].ptr != static_cast<const void*>(ptr)) {
+                    throw bad_archive("Could not archive a reference to a part of an object");
+                }
+
+                write_varint(internal::ARCHIVE_REF_FIRST_INDEX + result.first);
+                return;
+            }
+
+            Object& object {m_objects.emplace_back()};
+            object.ptr = ptr;
+
+            if (block) {
+                internal::ControlBlock weak {block};
+                weak.acquire_weak();
+                object.block = internal::WeakBlock(weak);
+            }
+
+            // Registered before writing the object itself, so that it can refer back to itself
+            write_varint(internal::ARCHIVE_REF_NEW);
+            write(*ptr);
+        }
+
+        void write_varint(std::uint64_t value) {
+            unsigned char bytes[10] {};
+            std::size_t size {0};
+
+            do {
+                bytes[size] = static_cast<unsigned char>(value & 0x7F);
+                value >>= 7;
+                bytes[size++] |= value != 0 ? 0x80 : 0;
+            } while (value != 0);
+
+            write_bytes(bytes, size);
+        }
+
+        void write_bytes(const void* data, std::size_t size) {
+            if (m_buffer.size() + size > internal::ARCHIVE_BUFFER_SIZE) {
+                flush_buffer();
+
+                // Big chunks go straight to the stream
+                if (size >= internal::ARCHIVE_BUFFER_SIZE) {
+                    m_stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+                    return;
+                }
+            }
+
+            const auto bytes {static_cast<const char*>(data)};
+            m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+        }
+
+        void flush_buffer() {
+            m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+            m_buffer.clear();
+
+            if (!m_stream) {
+                throw bad_archive("Could not write the archive to the stream");
+            }
+        }
+
+        std::ostream& m_stream;
+        std::vector<char> m_buffer;
+        internal::ArchiveTable m_table;
+        std::vector<Object> m_objects;
+    };
+
+    // Reader of objects from a binary stream written by archive_writer, in the same order and with the same types
+    // Every object is created with make_shared, so serializable types read through shared_refs must be default
+    // constructible; references to the same object are read back as references to one object
+    // The reader keeps every object it has read alive, as later references may refer back to it, so objects that
+    // are only referenced by weak_refs expire once the reader is destroyed
+    // Bytes are taken from the buffer of the stream itself, never beyond what has been read, so whatever follows
+    // the archive in the stream is left for the caller
+    class archive_reader {
+    public:
+        explicit archive_reader(std::istream& stream)
+            : m_stream(stream), m_streambuf(stream.rdbuf()) {
+            if (m_streambuf == nullptr) {
+                throw bad_archive("Stream has no buffer to read the archive from");
+            }
+
+            std::uint32_t magic {};
+            std::uint32_t version {};
+
+            read(magic);
+
+            if (magic == internal::ARCHIVE_MAGIC_SWAPPED) {
+                throw bad_archive("Archive was written with a different byte order");
+            }
+
+            if (magic != internal::ARCHIVE_MAGIC) {
+                throw bad_archive("Stream is not an archive");
+            }
+
+            read(version);
+
+            if (version != internal::ARCHIVE_VERSION) {
+                throw bad_archive("Archive version is not supported");
+            }
+        }
+
+        ~archive_reader() noexcept = default;
+
+        archive_reader(const archive_reader&) = delete;
+        archive_reader& operator=(const archive_reader&) = delete;
+        archive_reader(archive_reader&&) = delete;
+        archive_reader& operator=(archive_reader&&) = delete;
+
+        // Read the values in order
+        template<typename... Ts>
+        void operator()(Ts&... values) {
+            (read(values), ...);
+        }
+
+        // Get the number of distinct objects managed by shared_refs read so far
+        std::size_t objects() const noexcept {
+            return m_objects.size();
+        }
+    private:
+        struct Object {
+            void* ptr {};
+            internal::TypeId type {};
+            internal::SharedBlock block;
+        };
+
+        template<typename T>
+        void read(T& value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                value = read_byte() != 0;
+            } else if constexpr (internal::is_archived_raw_v<T>) {
+                read_bytes(&value, sizeof(T));
+            } else {
+                static_assert(internal::is_serializable_v<T>, "Type must be serializable");
+
+                value.serialize(*this);
+            }
+        }
+
+        template<typename Char, typename Traits, typename Alloc>
+        void read(std::basic_string<Char, Traits, Alloc>& string) {
+            std::size_t remaining {read_size()};
+            string.clear();
+
+            // Grown in chunks, so that a corrupt size fails on the missing data, not on allocation
+            while (remaining > 0) {
+                const std::size_t chunk {std::min(remaining, internal::ARCHIVE_BUFFER_SIZE / sizeof(Char))};
+                const std::size_t size {string.size()};
+
+                string.resize(size + chunk);
+                read_bytes(string.data() + size, chunk * sizeof(Char));
+                remaining -= chunk;
+            }
+        }
+
+        template<typename T, typename Alloc>
+        void read(std::vector<T, Alloc>& vector) {
+            std::size_t remaining {read_size()};
+            vector.clear();
+
+            if constexpr (internal::is_archived_raw_v<T> && !std::is_same_v<T, bool>) {
+                while (remaining > 0) {
+                    const std::size_t chunk {std::min(remaining, internal::ARCHIVE_BUFFER_SIZE / sizeof(T))};
+                    const std::size_t size {vector.size()};
+
+                    vector.resize(size + chunk);
+                    read_bytes(vector.data() + size, chunk * sizeof(T));
+                    remaining -= chunk;
+                }
+            } else {
+                for (; remaining > 0; remaining--) {
+                    T element {};
+                    read(element);
+                    vector.push_back(std::move(element));
+                }
+            }
+        }
+
+        template<typename T>
+        void read(shared_ref<T>& ref) {
+            using U = std::remove_cv_t<T>;
+
+            const std::uint64_t tag {read_varint()};
+
+            if (tag == internal::ARCHIVE_REF_NULL) {
+                ref.reset();
+                return;
+            }
+
+            if (tag == internal::ARCHIVE_REF_NEW) {
+                static_assert(std::is_default_constructible_v<U>, "Type must be default constructible");
+
+                shared_ref<U> object {sm::make_shared<U>()};
+                shared_ref<U> kept {object};
+
+                // Registered before reading the object itself, so that it can refer back to itself
+                m_objects.push_back(Object {
+                    object.get(), internal::type_id<U>(), internal::SharedBlock(internal::RefAccess::release(kept))
+                });
+
+                read(*object);
+                ref = std::move(object);
+
+                return;
+            }
+
+            const std::uint64_t index {tag - internal::ARCHIVE_REF_FIRST_INDEX};
+
+            if (index >= m_objects.size()) {
+                throw bad_archive("Archive refers to an unknown object");
+            }
+
+            const Object& object {m_objects[static_cast<std::size_t>(index)]};
+
+            if (object.type != internal::type_id<U>()) {
+                throw bad_archive("Archive refers to an object of a different type");
+            }
+
+            internal::ControlBlock block {object.block.get()};
+            block.acquire_strong();
+
+            ref = internal::RefAccess::adopt(static_cast<T*>(static_cast<U*>(object.ptr)), block);
+        }
+
+        template<typename T>
+        void read(weak_ref<T>& ref) {
+            shared_ref<T> object;
+            read(object);
+
+            ref = object;
+        }
+
+        std::size_t read_size() {
+            const std::uint64_t size {read_varint()};
+
+            if (size > static_cast<std::uint64_t>(~std::size_t(0))) {
+                throw bad_archive("Archive contains a size too large");
+            }
+
+            return static_cast<std::size_t>(size);
+        }
+
+        std::uint64_t read_varint() {
+            std::uint64_t value {0};
+
+            for (unsigned int shift {0}; shift < 64; shift += 7) {
+                const auto byte {read_byte()};
+
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+
+            throw bad_archive("Archive contains an invalid integer");
+        }
+
+        // The stream buffer does its own buffering, so taking single bytes out of it is cheap
+        unsigned char read_byte() {
+            const auto byte {m_streambuf->sbumpc()};
+
+            if (byte == std::istream::traits_type::eof()) {
+                unexpected_end();
+            }
+
+            return static_cast<unsigned char>(byte);
+        }
+
+        void read_bytes(void* data, std::size_t size) {
+            const auto read {m_streambuf->sgetn(static_cast<char*>(data), static_cast<std::streamsize>(size))};
+
+            if (static_cast<std::size_t>(read) != size) {
+                unexpected_end();
+            }
+        }
+
+        [[noreturn]] void unexpected_end() {
+            m_stream.setstate(std::ios::eofbit | std::ios::failbit);
+
+            throw bad_archive("Archive ended unexpectedly");
+        }
+
+        std::istream& m_stream;
+        std::streambuf* m_streambuf {nullptr};
+        std::vector<Object> m_objects;
+    };
+}
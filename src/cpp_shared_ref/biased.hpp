@@ -0,0 +1,394 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <atomic>
+#include <memory>  // std::addressof
+
+namespace sm {
+    namespace internal {
+        struct BiasedBlockBase;
+
+        // Queue of the blocks owned by one thread, whose shared counter has been dropped below zero by other threads
+        // Only the owner thread can merge the biased counter of these blocks, so they wait for it here
+        // Other threads push onto the queue, the owner takes all of them at once
+        // The queue is referenced by the owner thread and by every block that it owns, as blocks outlive threads
+        class BiasQueue final {
+        public:
+            // Push a block that has just been marked as queued
+            // Return false, if the owner thread has already exited, in which case the caller must merge the block
+            bool push(BiasedBlockBase* block) noexcept;
+
+            // Merge every queued block, on the owner thread
+            void process() noexcept;
+
+            // Merge every queued block and make further pushes fail, when the owner thread exits
+            void close() noexcept;
+
+            void acquire() noexcept {
+                m_references.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void release() noexcept {
+                if (m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    delete this;
+                }
+            }
+        private:
+            static void merge_all(void* head) noexcept;
+
+            static inline char closed {};
+
+            std::atomic<void*> m_head {nullptr};
+            std::atomic<std::size_t> m_references {1};
+        };
+
+        // Queue of the current thread; trivially initialized, so that checking for the owner is only a load
+        inline thread_local BiasQueue* current_bias_queue {nullptr};
+
+        // Owner of the queue of the current thread, closing it when the thread exits
+        class BiasQueueHolder final {
+        public:
+            BiasQueueHolder()
+                : m_queue(new BiasQueue) {
+                current_bias_queue = m_queue;
+            }
+
+            ~BiasQueueHolder() noexcept {
+                current_bias_queue = nullptr;
+
+                m_queue->close();
+                m_queue->release();
+            }
+
+            BiasQueueHolder(const BiasQueueHolder&) = delete;
+            BiasQueueHolder& operator=(const BiasQueueHolder&) = delete;
+            BiasQueueHolder(BiasQueueHolder&&) = delete;
+            BiasQueueHolder& operator=(BiasQueueHolder&&) = delete;
+
+            BiasQueue* get() const noexcept {
+                return m_queue;
+            }
+        private:
+            BiasQueue* m_queue {nullptr};
+        };
+
+        inline BiasQueue* local_bias_queue() {
+            static thread_local BiasQueueHolder holder;
+
+            return holder.get();
+        }
+
+        // Control block with biased reference counting
+        // The owner thread counts its references in a plain counter, every other thread counts in an atomic one;
+        // the sum of the two is the real count, so the shared counter alone may well be negative
+        // When the biased counter drops to zero, or when the shared counter drops below zero, the block is merged:
+        // the biased counter is folded into the shared one and from then on every thread counts atomically
+        // The shared counter keeps two flags in its lowest bits, while the count is kept in steps of COUNT
+        struct BiasedBlockBase {
+            static constexpr std::int64_t MERGED {1};
+            static constexpr std::int64_t QUEUED {2};
+            static constexpr std::int64_t FLAGS {MERGED | QUEUED};
+            static constexpr std::int64_t COUNT {4};
+
+            explicit BiasedBlockBase(BiasQueue* queue) noexcept
+                : queue(queue) {
+                queue->acquire();
+            }
+
+            virtual ~BiasedBlockBase() noexcept {
+                queue->release();
+            }
+
+            // Destroy the object and free the block
+            virtual void dispose() noexcept = 0;
+
+            bool owned_by_this_thread() const noexcept {
+                return queue == current_bias_queue && !merged;
+            }
+
+            void increment() noexcept {
+                if (owned_by_this_thread()) {
+                    biased++;
+                } else {
+                    shared.fetch_add(COUNT, std::memory_order_relaxed);
+                }
+            }
+
+            void decrement() noexcept {
+                if (owned_by_this_thread()) {
+                    if (--biased == 0) {
+                        merge_implicitly();
+                    }
+                } else {
+                    decrement_shared();
+                }
+            }
+
+            // The owner dropped its last reference, so from now on the shared counter is the real count
+            void merge_implicitly() noexcept {
+                merged = true;
+
+                const std::int64_t old {shared.fetch_or(MERGED, std::memory_order_acq_rel)};
+
+                // A queued block is disposed by whoever merges it from the queue
+                if ((old & ~FLAGS) == 0 && (old & QUEUED) == 0) {
+                    dispose();
+                }
+            }
+
+            // Fold the biased counter into the shared one, by the thread that took the block off the queue
+            void merge_queued() noexcept {
+                const std::int64_t biased_count {merged ? 0 : static_cast<std::int64_t>(biased) * COUNT};
+
+                biased = 0;
+                merged = true;
+
+                std::int64_t old {shared.load(std::memory_order_relaxed)};
+                std::int64_t value {};
+
+                do {
+                    value = ((old + biased_count) | MERGED) & ~QUEUED;
+                } while (!shared.compare_exchange_weak(old, value, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+                if ((value & ~FLAGS) == 0) {
+                    dispose();
+                }
+            }
+
+            void decrement_shared() noexcept {
+                std::int64_t old {shared.load(std::memory_order_relaxed)};
+                std::int64_t value {};
+
+                do {
+                    value = old - COUNT;
+
+                    // Dropping below zero means that a reference counted by the owner has been released here;
+                    // the block is then queued for the owner to merge it, which keeps it alive until then
+                    if ((old & (MERGED | QUEUED)) == 0 && value < 0) {
+                        value |= QUEUED;
+                    }
+                } while (!shared.compare_exchange_weak(old, value, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+                if ((value & QUEUED) != 0 && (old & QUEUED) == 0) {
+                    if (!queue->push(this)) {
+                        merge_queued();
+                    }
+
+                    return;
+                }
+
+                if ((old & MERGED) != 0 && (value & ~FLAGS) == 0 && (value & QUEUED) == 0) {
+                    dispose();
+                }
+            }
+
+            BiasQueue* queue {nullptr};
+            std::size_t biased {1};  // Accessed only by the owner thread, or by anyone after it has exited
+            bool merged {false};  // Same as above
+            std::atomic<std::int64_t> shared {0};
+            BiasedBlockBase* next {nullptr};  // Link in the queue
+        };
+
+        inline bool BiasQueue::push(BiasedBlockBase* block) noexcept {
+            void* head {m_head.load(std::memory_order_acquire)};
+
+            do {
+                if (head == &closed) {
+                    return false;
+                }
+
+                block->next = static_cast<BiasedBlockBase*>(head);
+            } while (!m_head.compare_exchange_weak(head, block, std::memory_order_acq_rel, std::memory_order_acquire));
+
+            return true;
+        }
+
+        inline void BiasQueue::process() noexcept {
+            if (m_head.load(std::memory_order_relaxed) == nullptr) {
+                return;
+            }
+
+            merge_all(m_head.exchange(nullptr, std::memory_order_acq_rel));
+        }
+
+        inline void BiasQueue::close() noexcept {
+            merge_all(m_head.exchange(&closed, std::memory_order_acq_rel));
+        }
+
+        inline void BiasQueue::merge_all(void* head) noexcept {
+            auto block {static_cast<BiasedBlockBase*>(head)};
+
+            while (block != nullptr) {
+                BiasedBlockBase* next {block->next};
+                block->merge_queued();  // May dispose the block
+                block = next;
+            }
+        }
+
+        template<typename T>
+        class BiasedBlockInPlace final : public BiasedBlockBase {
+        public:
+            template<typename... Args>
+            BiasedBlockInPlace(BiasQueue* queue, Args&&... args)
+                : BiasedBlockBase(queue) {
+                ::new (std::addressof(m_impl.object)) T(std::forward<Args>(args)...);
+            }
+
+            ~BiasedBlockInPlace() noexcept override {
+                m_impl.object.~T();
+            }
+
+            void dispose() noexcept override {
+                delete this;
+            }
+
+            T* get_ptr() noexcept {
+                return std::addressof(m_impl.object);
+            }
+        private:
+            union Impl {
+                Impl() {}
+                ~Impl() {}
+
+                T object;
+            } m_impl;
+        };
+    }
+
+    template<typename T>
+    class biased_ref;
+
+    template<typename T, typename... Args>
+    biased_ref<T> make_biased(Args&&... args);
+
+    // Smart pointer for objects that are mostly used by the thread that created them, but that may be shared with
+    // other threads, using biased reference counting
+    // Copies and destructions on the creating thread only touch a plain counter, while on other threads they are
+    // atomic operations; when the creating thread is done with the object, all of them become atomic
+    // References released on other threads may be left for the creating thread to account for, which it does from
+    // sm::merge_biased_refs(), from make_biased() and when it exits
+    // There are no weak references and no aliasing
+    template<typename T>
+    class biased_ref {
+    public:
+        using element_type = T;
+
+        // Construct an empty biased_ref
+        biased_ref() noexcept = default;
+
+        // Destroy this biased_ref, destroying the object, if this was the last reference to it
+        ~biased_ref() noexcept {
+            if (m_block != nullptr) {
+                m_block->decrement();
+            }
+        }
+
+        biased_ref(const biased_ref& other) noexcept
+            : m_ptr(other.m_ptr), m_block(other.m_block) {
+            if (m_block != nullptr) {
+                m_block->increment();
+            }
+        }
+
+        biased_ref& operator=(const biased_ref& other) noexcept {
+            biased_ref(other).swap(*this);
+
+            return *this;
+        }
+
+        biased_ref(biased_ref&& other) noexcept
+            : m_ptr(other.m_ptr), m_block(other.m_block) {
+            other.m_ptr = nullptr;
+            other.m_block = nullptr;
+        }
+
+        biased_ref& operator=(biased_ref&& other) noexcept {
+            biased_ref(std::move(other)).swap(*this);
+
+            return *this;
+        }
+
+        // Make this biased_ref empty, releasing its reference
+        void reset() noexcept {
+            biased_ref().swap(*this);
+        }
+
+        // Swap this biased_ref with another one
+        void swap(biased_ref& other) noexcept {
+            std::swap(m_ptr, other.m_ptr);
+            std::swap(m_block, other.m_block);
+        }
+
+        element_type* get() const noexcept {
+            return m_ptr;
+        }
+
+        T& operator*() const noexcept {
+            return *m_ptr;
+        }
+
+        T* operator->() const noexcept {
+            return m_ptr;
+        }
+
+        // Check if the object is counted with the plain counter on the current thread
+        bool owned_by_this_thread() const noexcept {
+            return m_block != nullptr && m_block->owned_by_this_thread();
+        }
+
+        // Check if this biased_ref holds an object
+        explicit operator bool() const noexcept {
+            return m_ptr != nullptr;
+        }
+    private:
+        element_type* m_ptr {nullptr};
+        internal::BiasedBlockBase* m_block {nullptr};
+
+        template<typename U, typename... Args>
+        friend biased_ref<U> make_biased(Args&&... args);
+    };
+
+    // Construct an object owned by a biased_ref, allocating the object and the control block together
+    // The calling thread becomes the owner of the object
+    template<typename T, typename... Args>
+    biased_ref<T> make_biased(Args&&... args) {
+        internal::BiasQueue* queue {internal::local_bias_queue()};
+        queue->process();
+
+        auto block {new internal::BiasedBlockInPlace<T>(queue, std::forward<Args>(args)...)};
+
+        biased_ref<T> result;
+        result.m_ptr = block->get_ptr();
+        result.m_block = block;
+
+        return result;
+    }
+
+    // Account for the references to objects owned by the current thread, that have been released on other threads
+    // Objects whose last reference was released that way are destroyed here
+    inline void merge_biased_refs() noexcept {
+        if (internal::current_bias_queue != nullptr) {
+            internal::current_bias_queue->process();
+        }
+    }
+
+    template<typename T, typename U>
+    bool operator==(const biased_ref<T>& lhs, const biased_ref<U>& rhs) noexcept {
+        return lhs.get() == rhs.get();
+    }
+
+    template<typename T, typename U>
+    bool operator!=(const biased_ref<T>& lhs, const biased_ref<U>& rhs) noexcept {
+        return lhs.get() != rhs.get();
+    }
+}
+
+namespace std {
+    // Swap two biased_ref objects
+    template<typename T>
+    void swap(sm::biased_ref<T>& lhs, sm::biased_ref<T>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
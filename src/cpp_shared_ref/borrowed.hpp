@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include <cassert>
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    // Non-owning view of an object managed by shared_ref, that doesn't touch the reference counts
+    // It's meant for function parameters and traversals, where the caller keeps the object alive anyway
+    // Consists of the object pointer and the control block, so an owning shared_ref can be made from it on demand
+    // With CPP_SHARED_REF_CHECK_BORROW it observes the control block like a weak_ref, so that using a borrowed_ref
+    // after the object has been destroyed is caught by an assertion; without it, it's trivially copyable
+    // The option changes how borrowed_refs update the counts, so it must be the same in the whole program
+    template<typename T>
+    class borrowed_ref {
+    public:
+        using element_type = T;
+
+        // Construct an empty borrowed_ref
+        constexpr borrowed_ref() noexcept = default;
+
+        // Construct an empty borrowed_ref
+        constexpr borrowed_ref(std::nullptr_t) noexcept {}
+
+        // Borrow the object of a shared_ref
+        // The shared_ref, or another owner, must outlive this borrowed_ref
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        borrowed_ref(const shared_ref<U>& ref) noexcept
+            : m_ptr(ref.get()), m_block(internal::RefAccess::block(ref)) {
+            observe();
+        }
+
+        // Borrow the object of another borrowed_ref
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        borrowed_ref(const borrowed_ref<U>& other) noexcept
+            : m_ptr(other.m_ptr), m_block(other.m_block) {
+            observe();
+        }
+
+#ifdef CPP_SHARED_REF_CHECK_BORROW
+        ~borrowed_ref() noexcept {
+            if (m_block) {
+                m_block.release_weak();
+            }
+        }
+
+        borrowed_ref(const borrowed_ref& other) noexcept
+            : m_ptr(other.m_ptr), m_block(other.m_block) {
+            observe();
+        }
+
+        borrowed_ref& operator=(const borrowed_ref& other) noexcept {
+            borrowed_ref(other).swap(*this);
+
+            return *this;
+        }
+#endif
+
+        // Get an owning shared_ref to the object
+        // Without a control block, e.g. for immortal objects, the result stores the pointer without owning it
+        shared_ref<T> to_shared() const noexcept {
+            check();
+
+            internal::ControlBlock block {m_block};
+
+            if (block) {
+                block.acquire_strong();
+            }
+
+            return internal::RefAccess::adopt(m_ptr, block);
+        }
+
+        element_type* get() const noexcept {
+            check();
+
+            return m_ptr;
+        }
+
+        T& operator*() const noexcept {
+            check();
+
+            return *m_ptr;
+        }
+
+        T* operator->() const noexcept {
+            check();
+
+            return m_ptr;
+        }
+
+        // Get the number of shared_ref objects that own the borrowed object
+        std::size_t use_count() const noexcept {
+            if (!m_block) {
+                return 0;
+            }
+
+            return m_block.strong_count() & ~internal::ControlBlock::FROZEN;
+        }
+
+        // Swap this borrowed_ref with another one
+        void swap(borrowed_ref& other) noexcept {
+            std::swap(m_ptr, other.m_ptr);
+            std::swap(m_block, other.m_block);
+        }
+
+        // Check if this borrowed_ref views an object
+        explicit operator bool() const noexcept {
+            return m_ptr != nullptr;
+        }
+    private:
+        void observe() noexcept {
+#ifdef CPP_SHARED_REF_CHECK_BORROW
+            if (m_block) {
+                m_block.acquire_weak();
+            }
+#endif
+        }
+
+        void check() const noexcept {
+#ifdef CPP_SHARED_REF_CHECK_BORROW
+            assert((!m_block || m_block.strong_count() > 0) && "borrowed_ref used after the object has been destroyed");
+#endif
+        }
+
+        T* m_ptr {nullptr};
+        internal::ControlBlock m_block;
+
+        template<typename U>
+        friend class borrowed_ref;
+    };
+}
+
+// Comparison operators with another borrowed_ref or with nullptr
+
+template<typename T, typename U>
+bool operator==(const sm::borrowed_ref<T>& lhs, const sm::borrowed_ref<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U>
+bool operator!=(const sm::borrowed_ref<T>& lhs, const sm::borrowed_ref<U>& rhs) noexcept {
+    return lhs.get() != rhs.get();
+}
+
+template<typename T>
+bool operator==(const sm::borrowed_ref<T>& lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+
+template<typename T>
+bool operator==(std::nullptr_t, const sm::borrowed_ref<T>& rhs) noexcept {
+    return !rhs;
+}
+
+template<typename T>
+bool operator!=(const sm::borrowed_ref<T>& lhs, std::nullptr_t) noexcept {
+    return static_cast<bool>(lhs);
+}
+
+template<typename T>
+bool operator!=(std::nullptr_t, const sm::borrowed_ref<T>& rhs) noexcept {
+    return static_cast<bool>(rhs);
+}
+
+namespace std {
+    // Swap two borrowed_ref objects
+    template<typename T>
+    void swap(sm::borrowed_ref<T>& lhs, sm::borrowed_ref<T>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <new>
+#include <stdexcept>
+
+#if __has_include(<version>)
+    #include <version>
+#endif
+
+#ifdef __cpp_lib_span
+    #include <span>
+#endif
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    namespace internal {
+        // Control block followed by the bytes of a shared_buffer, in the same allocation
+        class ControlBlockBytes final : public ControlBlockBase {
+        public:
+            static ControlBlockBytes* create(std::size_t size) {
+                return ::new (::operator new(sizeof(ControlBlockBytes) + size)) ControlBlockBytes;
+            }
+
+            void destroy() const noexcept override {}
+
+            void* get_deleter(TypeId) noexcept override {
+                return nullptr;
+            }
+
+            std::byte* data() noexcept {
+                return reinterpret_cast<std::byte*>(this + 1);
+            }
+
+            // Called by the virtual destructor, as the block has been allocated by create
+            static void operator delete(void* ptr) noexcept {
+                ::operator delete(ptr);
+            }
+        private:
+            ControlBlockBytes() noexcept = default;
+        };
+    }
+
+    class shared_slice;
+
+    // Fixed-size mutable byte buffer, allocated together with its control block
+    // Copies share the same bytes
+    class shared_buffer {
+    public:
+        // Construct an empty shared_buffer
+        shared_buffer() noexcept = default;
+
+        // Allocate a buffer of this size
+        // The contents are left uninitialized
+        explicit shared_buffer(std::size_t size) {
+            const auto block {internal::ControlBlockBytes::create(size)};
+
+            m_data = block->data();
+            m_size = size;
+            m_block = internal::SharedBlock(internal::ControlBlock(internal::AdoptTag(), block));
+        }
+
+        // Allocate a buffer and copy these bytes into it
+        shared_buffer(const void* data, std::size_t size)
+            : shared_buffer(size) {
+            if (size > 0) {
+                std::memcpy(m_data, data, size);
+            }
+        }
+
+        std::byte* data() const noexcept {
+            return m_data;
+        }
+
+        std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        bool empty() const noexcept {
+            return m_size == 0;
+        }
+
+        std::byte& operator[](std::size_t index) const noexcept {
+            return m_data[index];
+        }
+
+        std::byte* begin() const noexcept {
+            return m_data;
+        }
+
+        std::byte* end() const noexcept {
+            return m_data + m_size;
+        }
+
+        // Get the number of shared_buffers and shared_slices sharing these bytes
+        std::size_t use_count() const noexcept {
+            if (!m_block.get()) {
+                return 0;
+            }
+
+            return m_block.get().strong_count() & ~internal::ControlBlock::FROZEN;
+        }
+
+        // Check if this shared_buffer holds any bytes
+        explicit operator bool() const noexcept {
+            return m_data != nullptr;
+        }
+
+#ifdef __cpp_lib_span
+        // Get a view of the bytes as a span
+        std::span<std::byte> as_span() const noexcept {
+            return std::span<std::byte>(m_data, m_size);
+        }
+#endif
+
+        // Get a read-only view of the whole buffer, that shares ownership with it
+        inline shared_slice slice() const noexcept;
+
+        // Get a read-only view of a part of the buffer, that shares ownership with it
+        // Throw std::out_of_range, if the range is outside of the buffer
+        inline shared_slice slice(std::size_t offset, std::size_t length) const;
+    private:
+        std::byte* m_data {nullptr};
+        std::size_t m_size {0};
+        internal::SharedBlock m_block;
+    };
+
+    // Read-only view of a range of bytes, that keeps the memory alive by sharing its ownership
+    // Consists of only a pointer, a length and a single control block reference
+    class shared_slice {
+    public:
+        // Construct an empty shared_slice
+        shared_slice() noexcept = default;
+
+        // Construct a shared_slice that shares ownership with a shared_ref, but views a range of bytes
+        // This is like the aliasing constructor of shared_ref
+        template<typename T>
+        shared_slice(const shared_ref<T>& owner, const void* data, std::size_t size) noexcept
+            : m_data(static_cast<const std::byte*>(data)), m_size(size) {
+            internal::ControlBlock block {internal::RefAccess::block(owner)};
+
+            if (block) {
+                block.acquire_strong();
+                m_block = internal::SharedBlock(block);
+            }
+        }
+
+        const std::byte* data() const noexcept {
+            return m_data;
+        }
+
+        std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        bool empty() const noexcept {
+            return m_size == 0;
+        }
+
+        const std::byte& operator[](std::size_t index) const noexcept {
+            return m_data[index];
+        }
+
+        const std::byte* begin() const noexcept {
+            return m_data;
+        }
+
+        const std::byte* end() const noexcept {
+            return m_data + m_size;
+        }
+
+        // Get the number of owners sharing the viewed bytes
+        std::size_t use_count() const noexcept {
+            if (!m_block.get()) {
+                return 0;
+            }
+
+            return m_block.get().strong_count() & ~internal::ControlBlock::FROZEN;
+        }
+
+        // Check if this shared_slice views any memory
+        explicit operator bool() const noexcept {
+            return m_data != nullptr;
+        }
+
+#ifdef __cpp_lib_span
+        // Get a view of the bytes as a span
+        // The span doesn't keep the memory alive
+        std::span<const std::byte> as_span() const noexcept {
+            return std::span<const std::byte>(m_data, m_size);
+        }
+#endif
+
+        // Get a shared_slice of the bytes from offset until the end
+        // Throw std::out_of_range, if offset is past the end
+        shared_slice subslice(std::size_t offset) const {
+            if (offset > m_size) {
+                throw std::out_of_range("Slice offset is out of range");
+            }
+
+            return shared_slice(m_data + offset, m_size - offset, m_block);
+        }
+
+        // Get a shared_slice of length bytes starting from offset
+        // Throw std::out_of_range, if the range is outside of this slice
+        shared_slice subslice(std::size_t offset, std::size_t length) const {
+            if (offset > m_size || length > m_size - offset) {
+                throw std::out_of_range("Slice range is out of range");
+            }
+
+            return shared_slice(m_data + offset, length, m_block);
+        }
+
+        // Split this slice into [0, position) and [position, size)
+        // Throw std::out_of_range, if position is past the end
+        std::pair<shared_slice, shared_slice> split_at(std::size_t position) const {
+            if (position > m_size) {
+                throw std::out_of_range("Split position is out of range");
+            }
+
+            return std::make_pair(
+                shared_slice(m_data, position, m_block),
+                shared_slice(m_data + position, m_size - position, m_block)
+            );
+        }
+
+        // Check if the other slice begins right where this one ends, in the same memory
+        bool adjacent_to(const shared_slice& other) const noexcept {
+            return m_block.get().base() == other.m_block.get().base() && m_data + m_size == other.m_data;
+        }
+    private:
+        shared_slice(const std::byte* data, std::size_t size, internal::SharedBlock block) noexcept
+            : m_data(data), m_size(size), m_block(std::move(block)) {}
+
+        const std::byte* m_data {nullptr};
+        std::size_t m_size {0};
+        internal::SharedBlock m_block;
+
+        friend class shared_buffer;
+        friend class shared_chain;
+    };
+
+    inline shared_slice shared_buffer::slice() const noexcept {
+        return shared_slice(m_data, m_size, m_block);
+    }
+
+    inline shared_slice shared_buffer::slice(std::size_t offset, std::size_t length) const {
+        if (offset > m_size || length > m_size - offset) {
+            throw std::out_of_range("Slice range is out of range");
+        }
+
+        return shared_slice(m_data + offset, length, m_block);
+    }
+
+    // Sequence of shared_slices that together make up a logical range of bytes
+    // Concatenating slices doesn't copy any payload bytes
+    class shared_chain {
+    public:
+        using const_iterator = std::vector<shared_slice>::const_iterator;
+
+        // Construct an empty shared_chain
+        shared_chain() noexcept = default;
+
+        // Append a slice to the end of the chain
+        // A slice that continues the last one in the same memory is merged with it
+        void append(shared_slice slice) {
+            if (slice.empty()) {
+                return;
+            }
+
+            m_size += slice.size();
+
+            if (!m_slices.empty() && m_slices.back().adjacent_to(slice)) {
+                m_slices.back().m_size += slice.size();
+                return;
+            }
+
+            m_slices.push_back(std::move(slice));
+        }
+
+        // Append all the slices of another chain to the end of this chain
+        void append(const shared_chain& other) {
+            for (const shared_slice& slice : other.m_slices) {
+                append(slice);
+            }
+        }
+
+        // Get the total number of bytes
+        std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        bool empty() const noexcept {
+            return m_size == 0;
+        }
+
+        const std::vector<shared_slice>& slices() const noexcept {
+            return m_slices;
+        }
+
+        const_iterator begin() const noexcept {
+            return m_slices.begin();
+        }
+
+        const_iterator end() const noexcept {
+            return m_slices.end();
+        }
+
+        // Copy all the bytes into contiguous memory of at least size() bytes
+        void copy_to(void* destination) const noexcept {
+            auto bytes {static_cast<std::byte*>(destination)};
+
+            for (const shared_slice& slice : m_slices) {
+                std::memcpy(bytes, slice.data(), slice.size());
+                bytes += slice.size();
+            }
+        }
+    private:
+        std::vector<shared_slice> m_slices;
+        std::size_t m_size {0};
+    };
+
+    // Concatenate two slices into a chain, without copying the bytes
+    inline shared_chain concat(shared_slice first, shared_slice second) {
+        shared_chain chain;
+        chain.append(std::move(first));
+        chain.append(std::move(second));
+
+        return chain;
+    }
+}
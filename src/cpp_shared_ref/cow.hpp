@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <cassert>
+
+#include "memory.hpp"
+
+namespace sm {
+    // Value wrapper with copy-on-write semantics
+    // Copies share the same object, which is cloned only when it is written to while being shared
+    // Moving leaves the source without a value, so a moved-from cow may only be assigned to or destroyed
+    template<typename T>
+    class cow {
+    public:
+        // Construct a cow holding a default-constructed value
+        cow()
+            : m_ref(sm::make_shared<T>()) {}
+
+        // Construct a cow holding a copy of the value
+        cow(const T& value)
+            : m_ref(sm::make_shared<T>(value)) {}
+
+        // Construct a cow holding the moved value
+        cow(T&& value)
+            : m_ref(sm::make_shared<T>(std::move(value))) {}
+
+        // Construct a cow holding a value constructed from these arguments
+        template<typename... Args>
+        explicit cow(std::in_place_t, Args&&... args)
+            : m_ref(sm::make_shared<T>(std::forward<Args>(args)...)) {}
+
+        // Construct a cow that shares the object of a shared_ref
+        // The shared_ref must not be empty
+        explicit cow(shared_ref<T> ref) noexcept
+            : m_ref(std::move(ref)) {}
+
+        // Get read-only access to the value, without ever cloning it
+        const T& read() const noexcept {
+            assert(m_ref && "cow used after being moved from");
+
+            return *m_ref;
+        }
+
+        const T& operator*() const noexcept {
+            return read();
+        }
+
+        const T* operator->() const noexcept {
+            return std::addressof(read());
+        }
+
+        // Get write access to the value
+        // The value is first cloned, if it is shared with other cow or shared_ref objects
+        // Weak references to the value are not considered and they will observe the changes
+        T& write() {
+            assert(m_ref && "cow used after being moved from");
+
+            if (!m_ref.unique()) {
+                m_ref = sm::make_shared<T>(std::as_const(*m_ref));
+            }
+
+            return *m_ref;
+        }
+
+        // Get write access to the value, like Rc::make_mut in Rust
+        // The value is first cloned, if it is shared with other cow or shared_ref objects
+        // If the value is not shared, but is observed by weak references, it is moved into a new object instead,
+        // which disassociates the weak references, so they expire
+        T& make_mut() {
+            assert(m_ref && "cow used after being moved from");
+
+            if (!m_ref.unique()) {
+                m_ref = sm::make_shared<T>(std::as_const(*m_ref));
+            } else if (internal::RefAccess::block(m_ref).weak_count() > 1) {
+                m_ref = sm::make_shared<T>(std::move(*m_ref));
+            }
+
+            return *m_ref;
+        }
+
+        // Get the number of cow and shared_ref objects sharing the value
+        std::size_t use_count() const noexcept {
+            return m_ref.use_count();
+        }
+
+        // Check if the value is not shared, in which case writing to it doesn't clone it
+        bool unique() const noexcept {
+            return m_ref.unique();
+        }
+
+        // Get a read-only shared_ref to the value, i.e. an O(1) snapshot of it
+        shared_ref<const T> share() const noexcept {
+            return m_ref;
+        }
+
+        // Get a weak_ref to the value, which is disassociated by make_mut
+        weak_ref<const T> observe() const noexcept {
+            return weak_ref<const T>(weak_ref<T>(m_ref));
+        }
+
+        // Swap this cow object with another one
+        void swap(cow& other) noexcept {
+            m_ref.swap(other.m_ref);
+        }
+    private:
+        shared_ref<T> m_ref;
+    };
+}
+
+namespace std {
+    // Swap two cow objects
+    template<typename T>
+    void swap(sm::cow<T>& lhs, sm::cow<T>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <unordered_set>
+
+#include "internal/control_block.hpp"
+#include "internal/graph.hpp"
+#include "memory.hpp"
+
+#ifndef CPP_SHARED_REF_FREEZE
+    #error "Freezing requires CPP_SHARED_REF_FREEZE to be defined in the whole program"
+#endif
+
+namespace sm {
+    template<typename T>
+    class frozen_ref;
+
+    template<typename T>
+    frozen_ref<T> freeze(shared_ref<T> root);
+
+    template<typename T>
+    shared_ref<T> thaw(frozen_ref<T>&& frozen) noexcept;
+
+    // Handle to a frozen graph of objects, made by sm::freeze
+    // While frozen, the control blocks of all the objects strongly reachable from the root are not counted, so
+    // references to them may be copied and destroyed from any thread; the graph must be treated as read-only
+    // All the references that are made while the graph is frozen must be destroyed before it is thawed, and the
+    // references that already existed must not be destroyed until then
+    // Destroying the handle thaws the graph and releases the root, so it's destroyed right there, if not shared
+    template<typename T>
+    class frozen_ref {
+    public:
+        // Construct an empty frozen_ref
+        frozen_ref() noexcept = default;
+
+        // Thaw the graph and release the root
+        ~frozen_ref() noexcept {
+            thaw_blocks();
+        }
+
+        frozen_ref(const frozen_ref&) = delete;
+        frozen_ref& operator=(const frozen_ref&) = delete;
+
+        frozen_ref(frozen_ref&& other) noexcept
+            : m_root(std::move(other.m_root)), m_blocks(std::move(other.m_blocks)) {
+            other.m_blocks.clear();
+        }
+
+        frozen_ref& operator=(frozen_ref&& other) noexcept {
+            thaw_blocks();
+
+            m_root = std::move(other.m_root);
+            m_blocks = std::move(other.m_blocks);
+            other.m_blocks.clear();
+
+            return *this;
+        }
+
+        // Get a reference to the root, which may be done from any thread
+        shared_ref<T> get() const noexcept {
+            return m_root;
+        }
+
+        T& operator*() const noexcept {
+            return *m_root;
+        }
+
+        T* operator->() const noexcept {
+            return m_root.get();
+        }
+
+        // Get the number of objects frozen by this handle
+        std::size_t size() const noexcept {
+            return m_blocks.size();
+        }
+
+        // Check if this frozen_ref holds a graph
+        explicit operator bool() const noexcept {
+            return static_cast<bool>(m_root);
+        }
+    private:
+        void thaw_blocks() noexcept {
+            for (internal::ControlBlock& block : m_blocks) {
+                block.thaw();
+            }
+
+            m_blocks.clear();
+        }
+
+        shared_ref<T> m_root;
+        std::vector<internal::ControlBlock> m_blocks;
+
+        template<typename U>
+        friend frozen_ref<U> freeze(shared_ref<U> root);
+
+        template<typename U>
+        friend shared_ref<U> thaw(frozen_ref<U>&& frozen) noexcept;
+    };
+
+    // Freeze the graph of objects reachable from the root, so that it can be shared read-only between threads
+    // The objects are walked through their visit_refs member function (see internal/graph.hpp), if they have one;
+    // objects that are already frozen are left to the handle that froze them
+    // Weak references are not followed and the objects they refer to must not be touched from other threads
+    template<typename T>
+    frozen_ref<T> freeze(shared_ref<T> root) {
+        frozen_ref<T> frozen;
+        std::unordered_set<const void*> visited;
+
+        auto on_ref {[&frozen, &visited](const internal::ControlBlock& block, bool strong) {
+            if (!strong || block.frozen() || !visited.insert(block.base()).second) {
+                return false;
+            }
+
+            frozen.m_blocks.push_back(block);
+            return true;
+        }};
+
+        internal::GraphWalker walker {on_ref};
+        walker(root);
+
+        for (internal::ControlBlock& block : frozen.m_blocks) {
+            block.freeze();
+        }
+
+        frozen.m_root = std::move(root);
+
+        return frozen;
+    }
+
+    // Thaw the graph, restoring the reference counting, and get the root back
+    template<typename T>
+    shared_ref<T> thaw(frozen_ref<T>&& frozen) noexcept {
+        frozen.thaw_blocks();
+
+        return std::move(frozen.m_root);
+    }
+}
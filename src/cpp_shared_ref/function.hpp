@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>  // std::invoke, std::bad_function_call
+#include <new>
+#include <utility>
+#include <type_traits>
+
+#include "internal/control_block.hpp"
+
+namespace sm {
+    template<typename Signature>
+    class shared_function;
+
+    // Copyable, type-erased callable, whose closure is allocated once together with its control block and shared
+    // between copies, instead of being copied like with std::function
+    // Copies only increment a count, and calls go through a single function pointer
+    // Stateless callables, like captureless lambdas, and function pointers are stored inline, without any allocation
+    // As the closure is shared, a mutable callable called through one copy is seen modified by the others
+    template<typename R, typename... Args>
+    class shared_function<R(Args...)> {
+    public:
+        // Construct an empty shared_function
+        shared_function() noexcept = default;
+
+        // Construct an empty shared_function
+        shared_function(std::nullptr_t) noexcept {}
+
+        // Construct a shared_function that calls this callable
+        template<
+            typename F,
+            typename Fn = std::decay_t<F>,
+            typename = std::enable_if_t<
+                !std::is_same_v<Fn, shared_function> && std::is_invocable_r_v<R, Fn&, Args...>
+            >
+        >
+        shared_function(F&& function) {
+            if constexpr (is_small<Fn>) {
+                ::new (static_cast<void*>(m_storage.small)) Fn(std::forward<F>(function));
+                m_invoke = &invoke_small<Fn>;
+            } else {
+                Fn* ptr {nullptr};
+                m_block = internal::SharedBlock(
+                    internal::ControlBlock(ptr, internal::MakeSharedTag(), std::forward<F>(function))
+                );
+                m_storage.object = ptr;
+                m_invoke = &invoke_large<Fn>;
+            }
+        }
+
+        shared_function(const shared_function&) noexcept = default;
+        shared_function& operator=(const shared_function&) noexcept = default;
+
+        shared_function(shared_function&& other) noexcept
+            : m_invoke(std::exchange(other.m_invoke, &invoke_empty)), m_storage(other.m_storage),
+            m_block(std::move(other.m_block)) {}
+
+        shared_function& operator=(shared_function&& other) noexcept {
+            shared_function(std::move(other)).swap(*this);
+
+            return *this;
+        }
+
+        shared_function& operator=(std::nullptr_t) noexcept {
+            shared_function().swap(*this);
+
+            return *this;
+        }
+
+        // Call the callable, or throw std::bad_function_call if it's empty
+        R operator()(Args... args) const {
+            return m_invoke(m_storage, std::forward<Args>(args)...);
+        }
+
+        // Get the number of shared_function objects sharing the closure, or zero if it's stored inline
+        std::size_t use_count() const noexcept {
+            return m_block.get() ? m_block.get().strong_count() : 0;
+        }
+
+        void swap(shared_function& other) noexcept {
+            std::swap(m_invoke, other.m_invoke);
+            std::swap(m_storage, other.m_storage);
+            m_block.swap(other.m_block);
+        }
+
+        explicit operator bool() const noexcept {
+            return m_invoke != &invoke_empty;
+        }
+
+        friend bool operator==(const shared_function& function, std::nullptr_t) noexcept {
+            return !function;
+        }
+
+        friend bool operator==(std::nullptr_t, const shared_function& function) noexcept {
+            return !function;
+        }
+
+        friend bool operator!=(const shared_function& function, std::nullptr_t) noexcept {
+            return static_cast<bool>(function);
+        }
+
+        friend bool operator!=(std::nullptr_t, const shared_function& function) noexcept {
+            return static_cast<bool>(function);
+        }
+    private:
+        // Either the address of the closure in its control block, or the closure itself
+        union Storage {
+            void* object;
+            alignas(void*) unsigned char small[sizeof(void*)];
+        };
+
+        using Invoke = R(*)(const Storage&, Args&&...);
+
+        // Only callables without state are stored inline, so that copying the storage keeps the sharing semantics
+        template<typename Fn>
+        static constexpr bool is_small {
+            (std::is_empty_v<Fn> || std::is_pointer_v<Fn>) &&
+            sizeof(Fn) <= sizeof(Storage) && alignof(Fn) <= alignof(Storage) &&
+            std::is_trivially_copyable_v<Fn> && std::is_trivially_destructible_v<Fn> &&
+            std::is_invocable_r_v<R, const Fn&, Args...>
+        };
+
+        // The callables stored inline have no state to modify, so they are called as const
+        template<typename Fn>
+        static R invoke_small(const Storage& storage, Args&&... args) {
+            const Fn& function {*std::launder(reinterpret_cast<const Fn*>(storage.small))};
+
+            if constexpr (std::is_void_v<R>) {
+                std::invoke(function, std::forward<Args>(args)...);
+            } else {
+                return std::invoke(function, std::forward<Args>(args)...);
+            }
+        }
+
+        template<typename Fn>
+        static R invoke_large(const Storage& storage, Args&&... args) {
+            Fn& function {*static_cast<Fn*>(storage.object)};
+
+            if constexpr (std::is_void_v<R>) {
+                std::invoke(function, std::forward<Args>(args)...);
+            } else {
+                return std::invoke(function, std::forward<Args>(args)...);
+            }
+        }
+
+        // Empty shared_functions call this one instead of checking for emptiness on every call
+        static R invoke_empty(const Storage&, Args&&...) {
+            throw std::bad_function_call();
+        }
+
+        Invoke m_invoke {&invoke_empty};
+        Storage m_storage {};
+        internal::SharedBlock m_block;
+    };
+}
+
+namespace std {
+    // Swap two shared_function objects
+    template<typename R, typename... Args>
+    void swap(sm::shared_function<R(Args...)>& lhs, sm::shared_function<R(Args...)>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
@@ -0,0 +1,574 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <tuple>
+#include <variant>
+#include <optional>
+#include <memory>  // std::unique_ptr
+#include <exception>
+#include <functional>  // std::invoke
+#include <type_traits>
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    // Object stored in a local_future as the result, when its local_promise is destroyed without setting one
+    struct broken_promise : public std::exception {
+        broken_promise() noexcept = default;
+        broken_promise(const broken_promise&) noexcept = default;
+
+        const char* what() const noexcept override {
+            return "Promise destroyed without setting a result";
+        }
+    };
+
+    // Object thrown when getting the result of a local_future that has none yet, or when setting the result of
+    // a local_promise a second time
+    struct bad_future : public std::exception {
+        bad_future() noexcept = default;
+        bad_future(const bad_future&) noexcept = default;
+
+        const char* what() const noexcept override {
+            return "Future has no result, or promise already has one";
+        }
+    };
+
+    template<typename T>
+    class local_future;
+
+    template<typename T>
+    class local_promise;
+
+    namespace internal {
+        template<typename T>
+        using FutureValue = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+        template<typename T>
+        struct FutureGet {
+            using type = const T&;
+        };
+
+        template<>
+        struct FutureGet<void> {
+            using type = void;
+        };
+
+        template<typename State>
+        struct Continuation {
+            virtual ~Continuation() noexcept = default;
+            virtual void run(const State& state) = 0;
+        };
+
+        template<typename State, typename F>
+        struct ContinuationImpl final : Continuation<State> {
+            explicit ContinuationImpl(F f)
+                : f(std::move(f)) {}
+
+            void run(const State& state) override {
+                f(state);
+            }
+
+            F f;
+        };
+
+        // Shared state of a local_promise and its local_futures, allocated together with its control block
+        // The futures own it, while the promise only observes it, so it expires once nobody waits for the result
+        // It keeps the states that it depends on alive, so that dropping the last future of a chain cancels it
+        template<typename T>
+        struct FutureState {
+            static constexpr std::size_t VALUE {1};
+            static constexpr std::size_t EXCEPTION {2};
+
+            bool ready() const noexcept {
+                return result.index() != 0;
+            }
+
+            template<typename F>
+            void on_ready(F&& f) {
+                if (ready()) {
+                    f(*this);
+                } else {
+                    continuations.push_back(
+                        std::make_unique<ContinuationImpl<FutureState, std::decay_t<F>>>(std::forward<F>(f))
+                    );
+                }
+            }
+
+            void complete() {
+                dependencies.clear();
+
+                const auto ready_continuations {std::move(continuations)};
+                continuations.clear();
+
+                for (const auto& continuation : ready_continuations) {
+                    continuation->run(*this);
+                }
+            }
+
+            std::variant<std::monostate, FutureValue<T>, std::exception_ptr> result;
+            std::vector<std::unique_ptr<Continuation<FutureState>>> continuations;
+            std::vector<SharedBlock> dependencies;
+        };
+
+        template<typename T>
+        struct is_local_future : std::false_type {};
+
+        template<typename T>
+        struct is_local_future<local_future<T>> : std::true_type {
+            using value_type = T;
+        };
+
+        template<typename T, typename F>
+        using ContinuationResult = typename std::conditional_t<
+            std::is_void_v<T>,
+            std::invoke_result<F>,
+            std::invoke_result<F, const T&>
+        >::type;
+
+        template<typename R, bool = is_local_future<R>::value>
+        struct Unwrapped {
+            using type = R;
+        };
+
+        template<typename R>
+        struct Unwrapped<R, true> {
+            using type = typename is_local_future<R>::value_type;
+        };
+
+        struct FutureAccess;
+    }
+
+    // Handle to the result of an asynchronous operation, for code running on a single thread, like an event loop
+    // Copies share the same result; the result is never waited for, but continuations can be attached with then
+    // Nothing is synchronized and the reference counting is not atomic
+    template<typename T>
+    class local_future {
+    public:
+        using value_type = T;
+
+        // Construct an invalid local_future
+        local_future() noexcept = default;
+
+        // Check if this local_future refers to a shared state
+        bool valid() const noexcept {
+            return static_cast<bool>(m_state);
+        }
+
+        // Check if the result, either a value or an exception, has been set
+        bool ready() const noexcept {
+            return m_state && m_state->ready();
+        }
+
+        // Check if the result is an exception
+        bool has_exception() const noexcept {
+            return m_state && m_state->result.index() == State::EXCEPTION;
+        }
+
+        // Get the value, or rethrow the exception
+        // Throw bad_future, if the result is not ready
+        typename internal::FutureGet<T>::type get() const {
+            if (!ready()) {
+                throw bad_future();
+            }
+
+            if (m_state->result.index() == State::EXCEPTION) {
+                std::rethrow_exception(std::get<State::EXCEPTION>(m_state->result));
+            }
+
+            if constexpr (!std::is_void_v<T>) {
+                return std::get<State::VALUE>(m_state->result);
+            }
+        }
+
+        // Attach a continuation that is called with the value, once it's ready, or right away, if it's already ready
+        // Return a future to the result of the continuation; if that is itself a local_future, it's unwrapped
+        // Exceptions skip the continuation and are forwarded to the returned future; exceptions thrown by
+        // the continuation are stored in it
+        // The continuation is cancelled, i.e. never called, if the returned future and its copies are all destroyed
+        template<typename F>
+        auto then(F&& f) const {
+            using Result = internal::ContinuationResult<T, std::decay_t<F>>;
+            using U = typename internal::Unwrapped<Result>::type;
+
+            if (!valid()) {
+                throw bad_future();
+            }
+
+            local_promise<U> promise;
+            local_future<U> future {promise.get_future()};
+            promise.depend_on(*this);
+
+            m_state->on_ready([promise = std::move(promise), f = std::forward<F>(f)](const State& state) mutable {
+                if (promise.cancelled()) {
+                    return;
+                }
+
+                if (state.result.index() == State::EXCEPTION) {
+                    promise.set_exception(std::get<State::EXCEPTION>(state.result));
+                    return;
+                }
+
+                try {
+                    if constexpr (internal::is_local_future<Result>::value) {
+                        Result inner {call(f, state)};
+                        promise.depend_on(inner);
+                        inner.forward_to(std::move(promise));
+                    } else if constexpr (std::is_void_v<Result>) {
+                        call(f, state);
+                        promise.set_value();
+                    } else {
+                        promise.set_value(call(f, state));
+                    }
+                } catch (...) {
+                    promise.set_exception(std::current_exception());
+                }
+            });
+
+            return future;
+        }
+
+        // Swap this local_future with another one
+        void swap(local_future& other) noexcept {
+            m_state.swap(other.m_state);
+        }
+    private:
+        using State = internal::FutureState<T>;
+
+        explicit local_future(shared_ref<State> state) noexcept
+            : m_state(std::move(state)) {}
+
+        template<typename F>
+        static decltype(auto) call(F& f, const State& state) {
+            if constexpr (std::is_void_v<T>) {
+                return std::invoke(f);
+            } else {
+                return std::invoke(f, std::get<State::VALUE>(state.result));
+            }
+        }
+
+        // Set the result of the promise to the result of this future, once it's ready
+        void forward_to(local_promise<T>&& promise) const {
+            m_state->on_ready([promise = std::move(promise)](const State& state) mutable {
+                if (state.result.index() == State::EXCEPTION) {
+                    promise.set_exception(std::get<State::EXCEPTION>(state.result));
+                } else {
+                    promise.set_value(std::get<State::VALUE>(state.result));
+                }
+            });
+        }
+
+        shared_ref<State> m_state;
+
+        template<typename U>
+        friend class local_future;
+
+        template<typename U>
+        friend class local_promise;
+
+        friend struct internal::FutureAccess;
+    };
+
+    // Producer of the result of a local_future
+    // The shared state is allocated once, together with its control block, and the promise only keeps a weak_ref to
+    // it, after the first future has been made; when all the futures are gone, the promise is cancelled
+    // Destroying a promise without setting a result stores broken_promise in its futures
+    template<typename T>
+    class local_promise {
+    public:
+        // Construct a local_promise with a new shared state
+        local_promise()
+            : m_pending(sm::make_shared<State>()), m_state(m_pending) {}
+
+        // Store broken_promise, if no result has been set
+        ~local_promise() noexcept {
+            if (!m_satisfied) {
+                if (shared_ref<State> state {m_state.lock()}) {
+                    m_satisfied = true;
+                    state->result.template emplace<State::EXCEPTION>(std::make_exception_ptr(broken_promise()));
+                    state->complete();
+                }
+            }
+        }
+
+        local_promise(const local_promise&) = delete;
+        local_promise& operator=(const local_promise&) = delete;
+
+        local_promise(local_promise&& other) noexcept
+            : m_pending(std::move(other.m_pending)), m_state(std::move(other.m_state)), m_satisfied(other.m_satisfied) {}
+
+        local_promise& operator=(local_promise&& other) noexcept {
+            local_promise(std::move(other)).swap(*this);
+
+            return *this;
+        }
+
+        // Get a local_future sharing the state of this promise
+        // The future is invalid, if the state has already been cancelled
+        local_future<T> get_future() noexcept {
+            if (m_pending) {
+                return local_future<T>(std::move(m_pending));
+            }
+
+            return local_future<T>(m_state.lock());
+        }
+
+        // Set the value and run the continuations
+        // Throw bad_future, if a result has already been set
+        // Nothing happens, if the promise has been cancelled
+        template<typename... Args>
+        void set_value(Args&&... args) {
+            if (m_satisfied) {
+                throw bad_future();
+            }
+
+            m_satisfied = true;
+
+            if (shared_ref<State> state {m_state.lock()}) {
+                state->result.template emplace<State::VALUE>(std::forward<Args>(args)...);
+                state->complete();
+            }
+        }
+
+        // Set the exception and run the continuations
+        // Throw bad_future, if a result has already been set
+        // Nothing happens, if the promise has been cancelled
+        void set_exception(std::exception_ptr exception) {
+            if (m_satisfied) {
+                throw bad_future();
+            }
+
+            m_satisfied = true;
+
+            if (shared_ref<State> state {m_state.lock()}) {
+                state->result.template emplace<State::EXCEPTION>(std::move(exception));
+                state->complete();
+            }
+        }
+
+        // Check if all the futures have been destroyed, so that nobody is waiting for the result anymore
+        bool cancelled() const noexcept {
+            return !m_pending && m_state.expired();
+        }
+
+        // Check if a result has been set
+        bool satisfied() const noexcept {
+            return m_satisfied;
+        }
+
+        // Swap this local_promise with another one
+        void swap(local_promise& other) noexcept {
+            m_pending.swap(other.m_pending);
+            m_state.swap(other.m_state);
+            std::swap(m_satisfied, other.m_satisfied);
+        }
+    private:
+        using State = internal::FutureState<T>;
+
+        // Keep the state of the future alive for as long as the state of this promise is alive
+        template<typename U>
+        void depend_on(const local_future<U>& future) {
+            if (shared_ref<State> state {m_state.lock()}) {
+                internal::ControlBlock block {internal::RefAccess::block(future.m_state)};
+                block.acquire_strong();
+                state->dependencies.emplace_back(block);
+            }
+        }
+
+        shared_ref<State> m_pending;
+        weak_ref<State> m_state;
+        bool m_satisfied {false};
+
+        template<typename U>
+        friend class local_future;
+
+        friend struct internal::FutureAccess;
+    };
+
+    namespace internal {
+        // Gives the combinators access to the internals of local_future and local_promise
+        struct FutureAccess {
+            template<typename T>
+            static FutureState<T>& state(const local_future<T>& future) noexcept {
+                return *future.m_state;
+            }
+
+            template<typename T, typename U>
+            static void depend_on(local_promise<T>& promise, const local_future<U>& future) {
+                promise.depend_on(future);
+            }
+        };
+
+        template<typename Aggregate, std::size_t I, typename T>
+        void when_all_subscribe(const shared_ref<Aggregate>& aggregate, const local_future<T>& future) {
+            FutureAccess::depend_on(aggregate->promise, future);
+
+            FutureAccess::state(future).on_ready([aggregate](const FutureState<T>& state) {
+                if (aggregate->promise.satisfied()) {
+                    return;
+                }
+
+                if (state.result.index() == FutureState<T>::EXCEPTION) {
+                    aggregate->promise.set_exception(std::get<FutureState<T>::EXCEPTION>(state.result));
+                    return;
+                }
+
+                std::get<I>(aggregate->values).emplace(std::get<FutureState<T>::VALUE>(state.result));
+
+                if (--aggregate->remaining == 0) {
+                    std::apply(
+                        [&aggregate](auto&... values) {
+                            aggregate->promise.set_value(std::move(*values)...);
+                        },
+                        aggregate->values
+                    );
+                }
+            });
+        }
+
+        template<typename Aggregate, typename... Ts, std::size_t... Is>
+        void when_all_subscribe(
+            const shared_ref<Aggregate>& aggregate,
+            std::index_sequence<Is...>,
+            const local_future<Ts>&... futures
+        ) {
+            (when_all_subscribe<Aggregate, Is>(aggregate, futures), ...);
+        }
+    }
+
+    // Make a local_future that is ready with this value
+    template<typename T, typename... Args>
+    local_future<T> make_ready_future(Args&&... args) {
+        local_promise<T> promise;
+        local_future<T> future {promise.get_future()};
+        promise.set_value(std::forward<Args>(args)...);
+
+        return future;
+    }
+
+    // Get a local_future that becomes ready with all the values, once all the futures are ready
+    // The first exception is forwarded instead
+    template<typename T>
+    local_future<std::vector<T>> when_all(const std::vector<local_future<T>>& futures) {
+        static_assert(!std::is_void_v<T>, "Futures must have values");
+
+        struct Aggregate {
+            explicit Aggregate(std::size_t count)
+                : values(count), remaining(count) {}
+
+            std::vector<std::optional<T>> values;
+            std::size_t remaining {0};
+            local_promise<std::vector<T>> promise;
+        };
+
+        shared_ref<Aggregate> aggregate {sm::make_shared<Aggregate>(futures.size())};
+        local_future<std::vector<T>> result {aggregate->promise.get_future()};
+
+        if (futures.empty()) {
+            aggregate->promise.set_value();
+            return result;
+        }
+
+        for (std::size_t i {0}; i < futures.size(); i++) {
+            internal::FutureAccess::depend_on(aggregate->promise, futures[i]);
+
+            internal::FutureAccess::state(futures[i]).on_ready([aggregate, i](const internal::FutureState<T>& state) {
+                local_promise<std::vector<T>>& promise {aggregate->promise};
+
+                if (promise.satisfied()) {
+                    return;
+                }
+
+                if (state.result.index() == internal::FutureState<T>::EXCEPTION) {
+                    promise.set_exception(std::get<internal::FutureState<T>::EXCEPTION>(state.result));
+                    return;
+                }
+
+                aggregate->values[i].emplace(std::get<internal::FutureState<T>::VALUE>(state.result));
+
+                if (--aggregate->remaining == 0) {
+                    std::vector<T> values;
+                    values.reserve(aggregate->values.size());
+
+                    for (std::optional<T>& value : aggregate->values) {
+                        values.push_back(std::move(*value));
+                    }
+
+                    promise.set_value(std::move(values));
+                }
+            });
+        }
+
+        return result;
+    }
+
+    // Get a local_future that becomes ready with the index and the value of the first future that becomes ready
+    // The result of the other futures is ignored; an exception is forwarded, if it comes first
+    template<typename T>
+    local_future<std::pair<std::size_t, T>> when_any(const std::vector<local_future<T>>& futures) {
+        static_assert(!std::is_void_v<T>, "Futures must have values");
+
+        using Promise = local_promise<std::pair<std::size_t, T>>;
+
+        shared_ref<Promise> promise {sm::make_shared<Promise>()};
+        local_future<std::pair<std::size_t, T>> result {promise->get_future()};
+
+        for (std::size_t i {0}; i < futures.size(); i++) {
+            internal::FutureAccess::depend_on(*promise, futures[i]);
+
+            internal::FutureAccess::state(futures[i]).on_ready([promise, i](const internal::FutureState<T>& state) {
+                if (promise->satisfied()) {
+                    return;
+                }
+
+                if (state.result.index() == internal::FutureState<T>::EXCEPTION) {
+                    promise->set_exception(std::get<internal::FutureState<T>::EXCEPTION>(state.result));
+                } else {
+                    promise->set_value(i, std::get<internal::FutureState<T>::VALUE>(state.result));
+                }
+            });
+        }
+
+        return result;
+    }
+
+    // Get a local_future that becomes ready with the values of all the futures as a tuple
+    // Futures without a value contribute std::monostate; the first exception is forwarded instead
+    template<typename... Ts>
+    local_future<std::tuple<internal::FutureValue<Ts>...>> when_all(const local_future<Ts>&... futures) {
+        using Tuple = std::tuple<internal::FutureValue<Ts>...>;
+
+        struct Aggregate {
+            std::tuple<std::optional<internal::FutureValue<Ts>>...> values;
+            std::size_t remaining {sizeof...(Ts)};
+            local_promise<Tuple> promise;
+        };
+
+        shared_ref<Aggregate> aggregate {sm::make_shared<Aggregate>()};
+        local_future<Tuple> result {aggregate->promise.get_future()};
+
+        if constexpr (sizeof...(Ts) == 0) {
+            aggregate->promise.set_value();
+        } else {
+            internal::when_all_subscribe(aggregate, std::index_sequence_for<Ts...>(), futures...);
+        }
+
+        return result;
+    }
+}
+
+namespace std {
+    // Swap two local_future objects
+    template<typename T>
+    void swap(sm::local_future<T>& lhs, sm::local_future<T>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // Swap two local_promise objects
+    template<typename T>
+    void swap(sm::local_promise<T>& lhs, sm::local_promise<T>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
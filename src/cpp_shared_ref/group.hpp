@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+#include "memory.hpp"
+
+namespace sm {
+    namespace internal {
+        template<std::size_t I, typename T>
+        struct GroupElement {
+            GroupElement()
+                : value() {}
+
+            template<typename Tuple>
+            explicit GroupElement(Tuple&& args)
+                : value(std::make_from_tuple<T>(std::forward<Tuple>(args))) {}
+
+            T value;
+        };
+
+        template<typename Indices, typename... Ts>
+        struct Group;
+
+        // The objects of a group, laid out, constructed and destroyed like members of one object
+        template<std::size_t... Is, typename... Ts>
+        struct Group<std::index_sequence<Is...>, Ts...> : GroupElement<Is, Ts>... {
+            Group() = default;
+
+            template<typename... Tuples>
+            explicit Group(Tuples&&... args)
+                : GroupElement<Is, Ts>(std::forward<Tuples>(args))... {}
+        };
+
+        template<typename... Ts, typename G, std::size_t... Is>
+        std::tuple<shared_ref<Ts>...> make_group_refs(const shared_ref<G>& group, std::index_sequence<Is...>) {
+            std::tuple<shared_ref<Ts>...> refs {
+                shared_ref<Ts>(group, std::addressof(static_cast<GroupElement<Is, Ts>&>(*group).value))...
+            };
+
+            (RefAccess::check_shared_from_this(std::get<Is>(refs)), ...);
+
+            return refs;
+        }
+    }
+
+    // Construct several objects in one allocation, with one control block, and get a shared_ref to each of them
+    // The objects live and die together, as every shared_ref shares ownership of the whole group, like with the
+    // aliasing constructor
+    // Pass either no arguments, or one tuple of constructor arguments for every object, e.g. made by
+    // std::forward_as_tuple
+    template<typename... Ts, typename... Args>
+    std::tuple<shared_ref<Ts>...> make_shared_group(Args&&... args) {
+        static_assert(sizeof...(Ts) > 0, "Group must have at least one object");
+        static_assert(
+            sizeof...(Args) == 0 || sizeof...(Args) == sizeof...(Ts),
+            "There must be one tuple of arguments for every object"
+        );
+
+        using Group = internal::Group<std::index_sequence_for<Ts...>, Ts...>;
+
+        const shared_ref<Group> group {sm::make_shared<Group>(std::forward<Args>(args)...)};
+
+        return internal::make_group_refs<Ts...>(group, std::index_sequence_for<Ts...>());
+    }
+}
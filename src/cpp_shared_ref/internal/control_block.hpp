@@ -2,15 +2,54 @@
 
 #include <cstddef>
 #include <utility>
-#include <typeinfo>
 #include <memory>  // std::addressof
+#include <string_view>
 
 namespace sm {
     namespace internal {
+        // Identifier of a type that doesn't rely on RTTI
+        // Every type gets its own static tag object, the address of which is unique in the program
+        using TypeId = const void*;
+
+        template<typename T>
+        struct TypeTag {
+            static inline char id {};
+        };
+
+        template<typename T>
+        constexpr TypeId type_id() noexcept {
+            return &TypeTag<T>::id;
+        }
+
+        // Reference count events recorded with CPP_SHARED_REF_TRACE
+        enum class TraceKind : unsigned char {
+            Create,
+            Copy,
+            Release,
+            Destroy,
+            Lock,
+            WeakCopy,
+            WeakRelease,
+            Mark
+        };
+
+#ifdef CPP_SHARED_REF_TRACE
+        // Defined in trace.hpp, which is included at the end
+        inline void trace(TraceKind kind, const void* block, std::string_view name = {}) noexcept;
+
+        template<typename T>
+        constexpr std::string_view type_name() noexcept;
+#endif
+
         struct ControlBlockBase {
             virtual ~ControlBlockBase() noexcept = default;
             virtual void destroy() const noexcept = 0;
-            virtual void* get_deleter(const std::type_info& ti) noexcept = 0;
+            virtual void* get_deleter(TypeId id) noexcept = 0;
+
+            // Free the block, after both the strong and the weak references have dropped to zero
+            virtual void dispose() noexcept {
+                delete this;
+            }
 
             std::size_t strong_count {1};
             std::size_t weak_count {1};
@@ -26,8 +65,8 @@ namespace sm {
                 m_deleter(m_object_ptr);
             }
 
-            void* get_deleter(const std::type_info& ti) noexcept override {
-                if (ti == typeid(Deleter)) {
+            void* get_deleter(TypeId id) noexcept override {
+                if (id == type_id<Deleter>()) {
                     return std::addressof(m_deleter);
                 } else {
                     return nullptr;
@@ -48,7 +87,7 @@ namespace sm {
                 delete m_object_ptr;
             }
 
-            void* get_deleter(const std::type_info&) noexcept override {
+            void* get_deleter(TypeId) noexcept override {
                 return nullptr;
             }
         private:
@@ -69,7 +108,7 @@ namespace sm {
                 m_impl.object.~T();
             }
 
-            void* get_deleter(const std::type_info&) noexcept override {
+            void* get_deleter(TypeId) noexcept override {
                 return nullptr;
             }
 
@@ -85,10 +124,75 @@ namespace sm {
             } m_impl;
         };
 
+        // Cache line size assumed by make_shared_aligned
+        inline constexpr std::size_t CACHE_LINE_SIZE {64};
+
+        template<std::size_t Align>
+        struct MakeSharedAlignedTag {};
+
+        // Same as ControlBlockInPlace, but the object is aligned to at least Align
+        // With Align being at least the cache line size, the object doesn't share a cache line with the counters
+        template<typename T, std::size_t Align>
+        class ControlBlockInPlaceAligned final : public ControlBlockBase {
+        public:
+            static_assert((Align & (Align - 1)) == 0, "Alignment must be a power of two");
+            static_assert(Align >= alignof(T), "Alignment must not be lower than the object's alignment");
+
+            template<typename... Args>
+            ControlBlockInPlaceAligned(Args&&... args) {
+                ::new (std::addressof(m_impl.object)) T(std::forward<Args>(args)...);
+            }
+
+            void destroy() const noexcept override {
+                m_impl.object.~T();
+            }
+
+            void* get_deleter(TypeId) noexcept override {
+                return nullptr;
+            }
+
+            T* get_ptr() noexcept {
+                return std::addressof(m_impl.object);
+            }
+        private:
+            union alignas(Align) Impl {
+                Impl() {}
+                ~Impl() {}
+
+                T object;
+            } m_impl;
+        };
+
+        // Block shared by all immortal objects, which owns nothing and lives for the whole program
+        // Both counters are one with the highest bit set, i.e. frozen for good, so they're never updated
+        class ControlBlockImmortal final : public ControlBlockBase {
+        public:
+            constexpr ControlBlockImmortal() noexcept {
+                strong_count = ~(~std::size_t(0) >> 1) | 1;
+                weak_count = strong_count;
+            }
+
+            void destroy() const noexcept override {}
+
+            void* get_deleter(TypeId) noexcept override {
+                return nullptr;
+            }
+
+            void dispose() noexcept override {}
+        };
+
+        inline ControlBlockImmortal immortal_block {};
+
+        struct AdoptTag {};
+
         class ControlBlock final {
         public:
             ControlBlock() noexcept = default;
 
+            // Take a control block that has been allocated by the caller
+            ControlBlock(AdoptTag, ControlBlockBase* base) noexcept
+                : m_base(base) {}
+
             template<typename T, typename Deleter>
             ControlBlock(T* ptr, Deleter deleter) {
                 try {
@@ -97,6 +201,8 @@ namespace sm {
                     deleter(ptr);
                     throw;
                 }
+
+                trace_create<T>();
             }
 
             template<typename T>
@@ -107,28 +213,118 @@ namespace sm {
                     delete ptr;
                     throw;
                 }
+
+                trace_create<T>();
             }
 
+            // Over-aligned blocks are allocated with the aligned operator new and, through the virtual destructor,
+            // freed with the matching aligned operator delete
             template<typename T, typename... Args>
             ControlBlock(T*& ptr, MakeSharedTag, Args&&... args) {
                 auto block {new ControlBlockInPlace<T>(std::forward<Args>(args)...)};
                 ptr = block->get_ptr();
                 m_base = block;
+                trace_create<T>();
+            }
+
+            template<typename T, std::size_t Align, typename... Args>
+            ControlBlock(T*& ptr, MakeSharedAlignedTag<Align>, Args&&... args) {
+                auto block {new ControlBlockInPlaceAligned<T, Align>(std::forward<Args>(args)...)};
+                ptr = block->get_ptr();
+                m_base = block;
+                trace_create<T>();
             }
 
             void destroy() const noexcept {
                 m_base->destroy();
             }
 
-            void* get_deleter(const std::type_info& ti) const noexcept {
-                return m_base->get_deleter(ti);
+            void* get_deleter(TypeId id) const noexcept {
+                return m_base->get_deleter(id);
             }
 
             void dispose() noexcept {
-                delete m_base;
+                m_base->dispose();
                 m_base = nullptr;
             }
 
+            // Take one strong reference, unless the block is frozen
+            // Taking it from a weak reference is traced as a lock instead of a copy
+            void acquire_strong(TraceKind kind = TraceKind::Copy) noexcept {
+                if (!frozen()) {
+                    trace(kind);
+                    strong_count()++;
+                }
+            }
+
+            // Take one weak reference, unless the block is frozen
+            void acquire_weak() noexcept {
+                if (!frozen()) {
+                    trace(TraceKind::WeakCopy);
+                    weak_count()++;
+                }
+            }
+
+            // Drop one strong reference, destroying the object and the block, if it was the last one
+            void release_strong() noexcept {
+                if (frozen()) {
+                    return;
+                }
+
+                trace(TraceKind::Release);
+
+                if (--strong_count() == 0) {
+                    trace(TraceKind::Destroy);
+                    destroy();
+
+                    if (--weak_count() == 0) {
+                        dispose();
+                    }
+                }
+            }
+
+            // Drop one weak reference, destroying the block, if it was the last one
+            void release_weak() noexcept {
+                if (frozen()) {
+                    return;
+                }
+
+                trace(TraceKind::WeakRelease);
+
+                if (--weak_count() == 0 && strong_count() == 0) {
+                    dispose();
+                }
+            }
+
+            // A frozen block is not counted at all, so its references can be copied and destroyed from any thread
+            // The flag is the highest bit of both counters, which keeps frozen blocks from ever looking unique
+            // Checking the flag costs a load and a branch on every count update, so it's only done with
+            // CPP_SHARED_REF_FREEZE; otherwise the only frozen block is the immortal one, which is told apart by its
+            // address, without a load
+            bool frozen() const noexcept {
+#ifdef CPP_SHARED_REF_FREEZE
+                return (m_base->strong_count & FROZEN) != 0;
+#else
+                return immortal();
+#endif
+            }
+
+            bool immortal() const noexcept {
+                return m_base == &immortal_block;
+            }
+
+            void freeze() noexcept {
+                m_base->strong_count |= FROZEN;
+                m_base->weak_count |= FROZEN;
+            }
+
+            void thaw() noexcept {
+                m_base->strong_count &= ~FROZEN;
+                m_base->weak_count &= ~FROZEN;
+            }
+
+            static constexpr std::size_t FROZEN {~(~std::size_t(0) >> 1)};
+
             std::size_t strong_count() const noexcept {
                 return m_base->strong_count;
             }
@@ -152,8 +348,135 @@ namespace sm {
             const void* base() const noexcept {
                 return m_base;
             }
+
+            // Record an event on this block, if tracing is compiled in and started
+            void trace(TraceKind kind) const noexcept {
+#ifdef CPP_SHARED_REF_TRACE
+                internal::trace(kind, m_base);
+#else
+                static_cast<void>(kind);
+#endif
+            }
         private:
+            // Blocks adopted from the caller are not traced as created, so their events have no type
+            template<typename T>
+            void trace_create() const noexcept {
+#ifdef CPP_SHARED_REF_TRACE
+                internal::trace(TraceKind::Create, m_base, type_name<T>());
+#endif
+            }
+
             ControlBlockBase* m_base {nullptr};
         };
+
+        // Holder of one strong reference to a control block, for objects that are not shared_refs themselves
+        class SharedBlock final {
+        public:
+            SharedBlock() noexcept = default;
+
+            // Take over one strong reference, without incrementing it
+            explicit SharedBlock(ControlBlock block) noexcept
+                : m_block(block) {}
+
+            ~SharedBlock() noexcept {
+                if (m_block) {
+                    m_block.release_strong();
+                }
+            }
+
+            SharedBlock(const SharedBlock& other) noexcept
+                : m_block(other.m_block) {
+                if (m_block) {
+                    m_block.acquire_strong();
+                }
+            }
+
+            SharedBlock& operator=(const SharedBlock& other) noexcept {
+                SharedBlock(other).swap(*this);
+
+                return *this;
+            }
+
+            SharedBlock(SharedBlock&& other) noexcept
+                : m_block(other.m_block) {
+                other.m_block = {};
+            }
+
+            SharedBlock& operator=(SharedBlock&& other) noexcept {
+                SharedBlock(std::move(other)).swap(*this);
+
+                return *this;
+            }
+
+            void swap(SharedBlock& other) noexcept {
+                std::swap(m_block, other.m_block);
+            }
+
+            const ControlBlock& get() const noexcept {
+                return m_block;
+            }
+        private:
+            ControlBlock m_block;
+        };
+
+        // Holder of one weak reference to a control block, for objects that are not weak_refs themselves
+        class WeakBlock final {
+        public:
+            WeakBlock() noexcept = default;
+
+            // Take over one weak reference, without incrementing it
+            explicit WeakBlock(ControlBlock block) noexcept
+                : m_block(block) {}
+
+            ~WeakBlock() noexcept {
+                if (m_block) {
+                    m_block.release_weak();
+                }
+            }
+
+            WeakBlock(const WeakBlock& other) noexcept
+                : m_block(other.m_block) {
+                if (m_block) {
+                    m_block.acquire_weak();
+                }
+            }
+
+            WeakBlock& operator=(const WeakBlock& other) noexcept {
+                WeakBlock(other).swap(*this);
+
+                return *this;
+            }
+
+            WeakBlock(WeakBlock&& other) noexcept
+                : m_block(other.m_block) {
+                other.m_block = {};
+            }
+
+            WeakBlock& operator=(WeakBlock&& other) noexcept {
+                WeakBlock(std::move(other)).swap(*this);
+
+                return *this;
+            }
+
+            void swap(WeakBlock& other) noexcept {
+                std::swap(m_block, other.m_block);
+            }
+
+            // Check if the object has been destroyed
+            // Without a block nothing keeps the object alive, so like a weak_ref, it counts as destroyed
+            bool expired() const noexcept {
+                return !m_block || m_block.strong_count() == 0;
+            }
+
+            const ControlBlock& get() const noexcept {
+                return m_block;
+            }
+        private:
+            ControlBlock m_block;
+        };
     }
 }
+
+#ifdef CPP_SHARED_REF_TRACE
+    #include "trace.hpp"
+#endif
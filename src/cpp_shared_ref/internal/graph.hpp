@@ -0,0 +1,72 @@
+#pragma once
+
+#include <utility>
+#include <type_traits>
+
+#include "control_block.hpp"
+#include "../memory.hpp"
+
+namespace sm {
+    namespace internal {
+        // A type is traceable, if it exposes the shared_refs and weak_refs that it holds, through the member function
+        //     template<typename Visitor>
+        //     void visit_refs(Visitor& visitor) const;
+        // which calls visitor(ref) for every one of them
+
+        struct ProbeVisitor {
+            template<typename Ref>
+            void operator()(const Ref&) const noexcept {}
+        };
+
+        template<typename T, typename = void>
+        struct is_traceable : std::false_type {};
+
+        template<typename T>
+        struct is_traceable<T, std::void_t<
+            decltype(std::declval<const T&>().visit_refs(std::declval<ProbeVisitor&>()))
+        >> : std::true_type {};
+
+        template<typename T>
+        inline constexpr bool is_traceable_v {is_traceable<std::remove_cv_t<T>>::value};
+
+        // Depth-first walk over the references of a graph of traceable objects
+        // on_ref(block, strong) is called for every non-empty, non-immortal reference found and returns true, if the
+        // referenced object should be visited as well; it's up to on_ref to not visit an object twice
+        template<typename OnRef>
+        class GraphWalker {
+        public:
+            explicit GraphWalker(OnRef& on_ref) noexcept
+                : m_on_ref(on_ref) {}
+
+            template<typename U>
+            void operator()(const shared_ref<U>& ref) {
+                const ControlBlock& block {RefAccess::block(ref)};
+
+                if (!block || block.immortal()) {
+                    return;
+                }
+
+                if (m_on_ref(block, true)) {
+                    if constexpr (is_traceable_v<U>) {
+                        if (ref) {
+                            ref->visit_refs(*this);
+                        }
+                    }
+                }
+            }
+
+            template<typename U>
+            void operator()(const weak_ref<U>& ref) {
+                const ControlBlock& block {RefAccess::block(ref)};
+
+                if (!block || block.immortal()) {
+                    return;
+                }
+
+                m_on_ref(block, false);
+            }
+        private:
+            OnRef& m_on_ref;
+        };
+    }
+}
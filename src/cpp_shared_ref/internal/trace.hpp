@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "control_block.hpp"
+
+#ifndef CPP_SHARED_REF_TRACE
+    #error "Tracing requires CPP_SHARED_REF_TRACE to be defined in the whole program"
+#endif
+
+namespace sm {
+    namespace internal {
+        // The name is the type of the object for creations and the name of the marker for marks
+        // This is the event as read back from its slot by flush
+        struct TraceEvent {
+            std::uint64_t timestamp;
+            const void* block;
+            const char* name;
+            std::uint32_t name_size;
+            TraceKind kind;
+        };
+
+        // Number of events each thread keeps before overwriting the oldest ones
+        inline constexpr std::size_t TRACE_BUFFER_SIZE {std::size_t(1) << 16};
+
+        // Slot of the ring buffer, published like a sequence lock, as flush may read it while it's being overwritten
+        // The sequence is the index of the event plus one, or zero while the slot is being written; the fields
+        // are atomics only so that reading a slot that is being overwritten is not a data race
+        struct TraceSlot {
+            std::atomic<std::uint64_t> sequence {0};
+            std::atomic<std::uint64_t> timestamp {0};
+            std::atomic<const void*> block {nullptr};
+            std::atomic<const char*> name {nullptr};
+            std::atomic<std::uint32_t> name_size {0};
+            std::atomic<TraceKind> kind {TraceKind::Mark};
+        };
+
+        // Ring buffer written only by its thread, without locking, and read by flush
+        struct TraceBuffer {
+            TraceSlot slots[TRACE_BUFFER_SIZE];
+            std::atomic<std::uint64_t> head {0};
+            std::atomic<bool> finished {false};
+            std::uint64_t flushed {0};
+            std::size_t thread {0};
+        };
+
+        struct TraceRegistry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<TraceBuffer>> buffers;
+            std::size_t next_thread {1};
+
+            // The type of every block that has been created, kept across flushes, as only creations record it
+            std::unordered_map<const void*, std::string_view> types;
+        };
+
+        inline TraceRegistry& trace_registry() {
+            static TraceRegistry registry;
+
+            return registry;
+        }
+
+        inline std::atomic<bool> trace_enabled {false};
+
+        inline thread_local TraceBuffer* trace_thread_buffer {nullptr};
+        inline thread_local bool trace_thread_exited {false};
+
+        // The buffer outlives its thread, until its last events have been flushed
+        struct TraceThreadExit {
+            ~TraceThreadExit() noexcept {
+                trace_thread_buffer->finished.store(true, std::memory_order_release);
+                trace_thread_buffer = nullptr;
+                trace_thread_exited = true;
+            }
+        };
+
+        inline TraceBuffer* trace_register_thread() noexcept {
+            if (trace_thread_exited) {
+                return nullptr;
+            }
+
+            try {
+                std::unique_ptr<TraceBuffer> buffer {new TraceBuffer()};
+                TraceBuffer* const result {buffer.get()};
+
+                TraceRegistry& registry {trace_registry()};
+
+                {
+                    std::lock_guard<std::mutex> lock {registry.mutex};
+                    result->thread = registry.next_thread++;
+                    registry.buffers.push_back(std::move(buffer));
+                }
+
+                static thread_local TraceThreadExit exit;
+                trace_thread_buffer = result;
+
+                return result;
+            } catch (...) {
+                // Give up tracing this thread
+                trace_thread_exited = true;
+
+                return nullptr;
+            }
+        }
+
+        // Kept out of line, so that the reference counting code around the check stays as small as without tracing
+#if defined(__GNUC__) || defined(__clang__)
+        [[gnu::noinline, gnu::cold]]
+#elif defined(_MSC_VER)
+        __declspec(noinline)
+#endif
+        inline void trace_record(TraceKind kind, const void* block, std::string_view name) noexcept {
+            TraceBuffer* buffer {trace_thread_buffer};
+
+            if (buffer == nullptr) {
+                buffer = trace_register_thread();
+
+                if (buffer == nullptr) {
+                    return;
+                }
+            }
+
+            const auto now {std::chrono::steady_clock::now().time_since_epoch()};
+            const std::uint64_t head {buffer->head.load(std::memory_order_relaxed)};
+
+            TraceSlot& slot {buffer->slots[head % TRACE_BUFFER_SIZE]};
+
+            slot.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            slot.timestamp.store(
+                static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()),
+                std::memory_order_relaxed
+            );
+            slot.block.store(block, std::memory_order_relaxed);
+            slot.name.store(name.data(), std::memory_order_relaxed);
+            slot.name_size.store(static_cast<std::uint32_t>(name.size()), std::memory_order_relaxed);
+            slot.kind.store(kind, std::memory_order_relaxed);
+
+            slot.sequence.store(head + 1, std::memory_order_release);
+            buffer->head.store(head + 1, std::memory_order_release);
+        }
+
+        // This is the only cost of tracing while it's stopped
+        inline void trace(TraceKind kind, const void* block, std::string_view name) noexcept {
+            if (trace_enabled.load(std::memory_order_relaxed)) {
+                trace_record(kind, block, name);
+            }
+        }
+
+        // Name of a type that doesn't rely on RTTI, taken from the signature of this very function
+        template<typename T>
+        constexpr std::string_view type_name() noexcept {
+#if defined(__clang__) || defined(__GNUC__)
+            constexpr std::string_view signature {__PRETTY_FUNCTION__};
+            constexpr std::size_t begin {signature.find("T = ") + 4};
+            constexpr std::size_t end {signature.find_first_of(";]", begin)};
+#elif defined(_MSC_VER)
+            constexpr std::string_view signature {__FUNCSIG__};
+            constexpr std::size_t begin {signature.find("type_name<") + 10};
+            constexpr std::size_t end {signature.rfind(">(void)")};
+#else
+            constexpr std::string_view signature {"unknown"};
+            constexpr std::size_t begin {0};
+            constexpr std::size_t end {signature.size()};
+#endif
+
+            return signature.substr(begin, end - begin);
+        }
+    }
+}
@@ -6,6 +6,7 @@
 #include <memory>  // std::unique_ptr, std::hash
 #include <exception>
 #include <type_traits>
+#include <atomic>
 
 #include "internal/control_block.hpp"
 
@@ -23,6 +24,10 @@ namespace sm {
 }
 
 namespace sm {
+    namespace internal {
+        struct RefAccess;
+    }
+
     template<typename T>
     class weak_ref;
 
@@ -67,7 +72,7 @@ namespace sm {
         shared_ref(const shared_ref<U>& other, T* ptr) noexcept
             : m_ptr(ptr), m_block(other.m_block) {
             if (m_block) {
-                m_block.strong_count()++;
+                m_block.acquire_strong();
             }
         }
 
@@ -82,7 +87,9 @@ namespace sm {
             m_ptr = ref.m_ptr;
             m_block = ref.m_block;
 
-            m_block.strong_count()++;
+            if (m_block) {
+                m_block.acquire_strong(internal::TraceKind::Lock);
+            }
         }
 
         // Construct a shared_ref that takes ownership from a unique_ptr
@@ -111,7 +118,7 @@ namespace sm {
         shared_ref(const shared_ref& other) noexcept
             : m_ptr(other.m_ptr), m_block(other.m_block) {
             if (m_block) {
-                m_block.strong_count()++;
+                m_block.acquire_strong();
             }
         }
 
@@ -121,7 +128,7 @@ namespace sm {
         shared_ref(const shared_ref<U>& other) noexcept
             : m_ptr(other.m_ptr), m_block(other.m_block) {
             if (m_block) {
-                m_block.strong_count()++;
+                m_block.acquire_strong();
             }
         }
 
@@ -134,7 +141,7 @@ namespace sm {
             m_block = other.m_block;
 
             if (m_block) {
-                m_block.strong_count()++;
+                m_block.acquire_strong();
             }
 
             return *this;
@@ -150,7 +157,7 @@ namespace sm {
             m_block = other.m_block;
 
             if (m_block) {
-                m_block.strong_count()++;
+                m_block.acquire_strong();
             }
 
             return *this;
@@ -226,12 +233,13 @@ namespace sm {
                 return 0;
             }
 
-            return m_block.strong_count();
+            return m_block.strong_count() & ~internal::ControlBlock::FROZEN;
         }
 
         // Check if the managed object has only one reference
+        // A frozen object is never unique
         bool unique() const noexcept {
-            return use_count() == 1;
+            return m_block && m_block.strong_count() == 1;
         }
 
         // Check if the stored pointer is not null
@@ -289,13 +297,32 @@ namespace sm {
             std::swap(m_ptr, other.m_ptr);
             std::swap(m_block, other.m_block);
         }
+
+        // Construct an immortal shared_ref to an object that outlives all of its references, e.g. a static one
+        // Immortal refs share a static control block, which is frozen for good, so copying and destroying them never
+        // update a count; they report a use count of one, are never unique and weak_refs to them never expire
+        static shared_ref immortal(T& object) noexcept {
+            shared_ref ref;
+            ref.m_ptr = std::addressof(object);
+            ref.m_block = internal::ControlBlock(internal::AdoptTag(), &internal::immortal_block);
+
+            return ref;
+        }
+
+        // Check if this shared_ref is immortal, i.e. it has the control block of immortal objects
+        bool is_immortal() const noexcept {
+            return m_block.immortal();
+        }
     private:
         void destroy_this() noexcept {
-            if (!m_block) {
+            if (!m_block || m_block.frozen()) {
                 return;
             }
 
+            m_block.trace(internal::TraceKind::Release);
+
             if (--m_block.strong_count() == 0) {
+                m_block.trace(internal::TraceKind::Destroy);
                 m_ptr = nullptr;
                 m_block.destroy();
 
@@ -333,6 +360,9 @@ namespace sm {
         template<typename U, typename... Args>
         friend shared_ref<U> make_shared(Args&&... args);
 
+        template<typename U, std::size_t Align, typename... Args>
+        friend shared_ref<U> make_shared_aligned(Args&&... args);
+
         template<typename Deleter, typename U>
         friend Deleter* get_deleter(const shared_ref<U>& ref) noexcept;
 
@@ -341,6 +371,8 @@ namespace sm {
 
         template<typename U>
         friend class shared_ref;
+
+        friend struct internal::RefAccess;
     };
 
     // Construct a new shared_ref using new, with these arguments
@@ -353,6 +385,53 @@ namespace sm {
         return ref;
     }
 
+    // Construct a new shared_ref using new, with these arguments
+    // The object is aligned to Align and, by default, doesn't share a cache line with the reference counts
+    template<typename T, std::size_t Align = internal::CACHE_LINE_SIZE, typename... Args>
+    shared_ref<T> make_shared_aligned(Args&&... args) {
+        shared_ref<T> ref;
+        ref.m_block = internal::ControlBlock(
+            ref.m_ptr,
+            internal::MakeSharedAlignedTag<Align>(),
+            std::forward<Args>(args)...
+        );
+        ref.check_shared_from_this(ref.m_ptr);
+
+        return ref;
+    }
+
+    namespace internal {
+        // Objects created by make_immortal, which are never destroyed
+        // They are linked into a global list, so that they remain reachable for leak checkers
+        struct ImmortalNode {
+            ImmortalNode* next {nullptr};
+        };
+
+        inline std::atomic<ImmortalNode*> immortal_objects {nullptr};
+
+        template<typename T>
+        struct ImmortalObject : ImmortalNode {
+            template<typename... Args>
+            explicit ImmortalObject(Args&&... args)
+                : object(std::forward<Args>(args)...) {}
+
+            T object;
+        };
+    }
+
+    // Construct a new object that lives until the end of the program and get an immortal shared_ref to it
+    // The object is never destroyed; see shared_ref::immortal
+    template<typename T, typename... Args>
+    shared_ref<T> make_immortal(Args&&... args) {
+        auto node {new internal::ImmortalObject<T>(std::forward<Args>(args)...)};
+
+        node->next = internal::immortal_objects.load(std::memory_order_relaxed);
+
+        while (!internal::immortal_objects.compare_exchange_weak(node->next, node, std::memory_order_release)) {}
+
+        return shared_ref<T>::immortal(node->object);
+    }
+
     // Safely static_cast this shared_ref to another shared_ref
     template<typename T, typename U>
     shared_ref<T> static_ref_cast(const shared_ref<U>& ref) noexcept {
@@ -392,7 +471,7 @@ namespace sm {
     // Get a pointer to the deleter of the shared_ref object, or nullptr, if it doesn't have a custom deleter
     template<typename Deleter, typename T>
     Deleter* get_deleter(const shared_ref<T>& ref) noexcept {
-        return static_cast<Deleter*>(ref.m_block.get_deleter(typeid(Deleter)));
+        return static_cast<Deleter*>(ref.m_block.get_deleter(internal::type_id<std::remove_cv_t<Deleter>>()));
     }
 }
 
@@ -527,7 +606,7 @@ namespace sm {
         weak_ref(const shared_ref<T>& ref) noexcept
             : m_ptr(ref.m_ptr), m_block(ref.m_block) {
             if (m_block) {
-                m_block.weak_count()++;
+                m_block.acquire_weak();
             }
         }
 
@@ -545,7 +624,7 @@ namespace sm {
             m_block = ref.m_block;
 
             if (m_block) {
-                m_block.weak_count()++;
+                m_block.acquire_weak();
             }
 
             return *this;
@@ -556,7 +635,7 @@ namespace sm {
         weak_ref(const weak_ref& other) noexcept
             : m_ptr(other.m_ptr), m_block(other.m_block) {
             if (m_block) {
-                m_block.weak_count()++;
+                m_block.acquire_weak();
             }
         }
 
@@ -566,7 +645,7 @@ namespace sm {
         weak_ref(const weak_ref<U>& other) noexcept
             : m_ptr(other.m_ptr), m_block(other.m_block) {
             if (m_block) {
-                m_block.weak_count()++;
+                m_block.acquire_weak();
             }
         }
 
@@ -579,7 +658,7 @@ namespace sm {
             m_block = other.m_block;
 
             if (m_block) {
-                m_block.weak_count()++;
+                m_block.acquire_weak();
             }
 
             return *this;
@@ -595,7 +674,7 @@ namespace sm {
             m_block = other.m_block;
 
             if (m_block) {
-                m_block.weak_count()++;
+                m_block.acquire_weak();
             }
 
             return *this;
@@ -653,7 +732,7 @@ namespace sm {
                 return 0;
             }
 
-            return m_block.strong_count();
+            return m_block.strong_count() & ~internal::ControlBlock::FROZEN;
         }
 
         // Check if the managed object has been deleted
@@ -670,7 +749,9 @@ namespace sm {
                 ref.m_ptr = m_ptr;
                 ref.m_block = m_block;
 
-                ref.m_block.strong_count()++;
+                if (ref.m_block) {
+                    ref.m_block.acquire_strong(internal::TraceKind::Lock);
+                }
             }
 
             return ref;
@@ -703,10 +784,12 @@ namespace sm {
         }
     private:
         void destroy_this() noexcept {
-            if (!m_block) {
+            if (!m_block || m_block.frozen()) {
                 return;
             }
 
+            m_block.trace(internal::TraceKind::WeakRelease);
+
             if (--m_block.weak_count() == 0 && m_block.strong_count() == 0) {
                 m_block.dispose();
             }
@@ -718,7 +801,7 @@ namespace sm {
             m_block = block;
 
             if (m_block) {
-                m_block.weak_count()++;
+                m_block.acquire_weak();
             }
         }
 
@@ -730,9 +813,55 @@ namespace sm {
 
         template<typename U>
         friend class weak_ref;
+
+        friend struct internal::RefAccess;
     };
 }
 
+namespace sm {
+    namespace internal {
+        // Gives the other parts of the library access to the internals of shared_ref and weak_ref
+        struct RefAccess {
+            template<typename T>
+            static const ControlBlock& block(const shared_ref<T>& ref) noexcept {
+                return ref.m_block;
+            }
+
+            template<typename T>
+            static const ControlBlock& block(const weak_ref<T>& ref) noexcept {
+                return ref.m_block;
+            }
+
+            // Make a shared_ref that takes over one strong reference of the block, without incrementing it
+            template<typename T>
+            static shared_ref<T> adopt(T* ptr, ControlBlock block) noexcept {
+                shared_ref<T> ref;
+                ref.m_ptr = ptr;
+                ref.m_block = block;
+
+                return ref;
+            }
+
+            // Let the object share itself, if it derives from enable_shared_from_this
+            template<typename T>
+            static void check_shared_from_this(shared_ref<T>& ref) noexcept {
+                ref.check_shared_from_this(ref.m_ptr);
+            }
+
+            // Empty the shared_ref and give its strong reference to the caller, without decrementing it
+            template<typename T>
+            static ControlBlock release(shared_ref<T>& ref) noexcept {
+                const ControlBlock block {ref.m_block};
+
+                ref.m_ptr = nullptr;
+                ref.m_block = {};
+
+                return block;
+            }
+        };
+    }
+}
+
 namespace std {
     // Swap two weak_ref objects
     template<typename T>
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include <memory>  // std::addressof
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    namespace internal {
+        struct NoReset {
+            template<typename T>
+            void operator()(T&) const noexcept {}
+        };
+
+        template<typename T, typename Reset>
+        class ControlBlockPooled;
+
+        template<typename T, typename Reset>
+        struct PoolState {
+            explicit PoolState(Reset reset)
+                : reset(std::move(reset)) {}
+
+            std::vector<ControlBlockPooled<T, Reset>*> free;
+            Reset reset;
+            std::size_t outstanding {0};
+            bool alive {true};
+        };
+
+        // Control block that is not freed when the references drop to zero, but is given back to its pool together
+        // with the still constructed object
+        template<typename T, typename Reset>
+        class ControlBlockPooled final : public ControlBlockBase {
+        public:
+            template<typename... Args>
+            ControlBlockPooled(PoolState<T, Reset>* state, Args&&... args)
+                : m_state(state) {
+                ::new (std::addressof(m_impl.object)) T(std::forward<Args>(args)...);
+            }
+
+            ~ControlBlockPooled() noexcept override {
+                m_impl.object.~T();
+            }
+
+            // The object is not destroyed, only reset
+            void destroy() const noexcept override {
+                if (m_state->alive) {
+                    m_state->reset(m_impl.object);
+                }
+            }
+
+            void* get_deleter(TypeId) noexcept override {
+                return nullptr;
+            }
+
+            void dispose() noexcept override {
+                PoolState<T, Reset>* state {m_state};
+
+                if (state->alive) {
+                    strong_count = 1;
+                    weak_count = 1;
+
+                    state->free.push_back(this);
+                    state->outstanding--;
+
+                    return;
+                }
+
+                delete this;
+
+                // The pool has been destroyed in the meantime and this was the last block out
+                if (--state->outstanding == 0) {
+                    delete state;
+                }
+            }
+
+            T* get_ptr() noexcept {
+                return std::addressof(m_impl.object);
+            }
+        private:
+            PoolState<T, Reset>* m_state {nullptr};
+
+            mutable union Impl {
+                Impl() {}
+                ~Impl() {}
+
+                T object;
+            } m_impl;
+        };
+    }
+
+    // Pool of objects that are recycled instead of destroyed
+    // Every object is allocated together with its control block and the two are reused as a unit: when the last
+    // reference to an object is destroyed, the reset hook is called with the object and it's put back in the pool
+    // The pool may be destroyed before the objects it handed out
+    template<typename T, typename Reset = internal::NoReset>
+    class object_pool {
+    public:
+        static_assert(
+            !std::is_base_of_v<enable_shared_from_this<T>, T>,
+            "Objects deriving from enable_shared_from_this cannot be pooled"
+        );
+
+        // Construct an empty object_pool
+        object_pool()
+            : m_state(new internal::PoolState<T, Reset>(Reset())) {}
+
+        // Construct an empty object_pool with this reset hook
+        explicit object_pool(Reset reset)
+            : m_state(new internal::PoolState<T, Reset>(std::move(reset))) {}
+
+        // Destroy the pooled objects
+        // The objects that are still in use are destroyed when their last reference is destroyed
+        ~object_pool() noexcept {
+            shrink();
+
+            if (m_state->outstanding == 0) {
+                delete m_state;
+            } else {
+                m_state->alive = false;
+            }
+        }
+
+        object_pool(const object_pool&) = delete;
+        object_pool& operator=(const object_pool&) = delete;
+        object_pool(object_pool&&) = delete;
+        object_pool& operator=(object_pool&&) = delete;
+
+        // Get a recycled object, or construct a new one with these arguments, if the pool is empty
+        // Recycled objects are not constructed again, so the arguments are used only for new objects
+        template<typename... Args>
+        shared_ref<T> acquire(Args&&... args) {
+            Block* block {nullptr};
+
+            if (m_state->free.empty()) {
+                block = new Block(m_state, std::forward<Args>(args)...);
+            } else {
+                block = m_state->free.back();
+                m_state->free.pop_back();
+            }
+
+            m_state->outstanding++;
+
+            return internal::RefAccess::adopt(block->get_ptr(), internal::ControlBlock(internal::AdoptTag(), block));
+        }
+
+        // Construct new objects with these arguments, until there are at least count objects in the pool
+        template<typename... Args>
+        void reserve(std::size_t count, const Args&... args) {
+            m_state->free.reserve(count);
+
+            while (m_state->free.size() < count) {
+                m_state->free.push_back(new Block(m_state, args...));
+            }
+        }
+
+        // Destroy the objects in the pool
+        void shrink() noexcept {
+            for (Block* block : m_state->free) {
+                delete block;
+            }
+
+            m_state->free.clear();
+        }
+
+        // Get the number of objects ready to be recycled
+        std::size_t available() const noexcept {
+            return m_state->free.size();
+        }
+
+        // Get the number of objects currently in use
+        std::size_t in_use() const noexcept {
+            return m_state->outstanding;
+        }
+    private:
+        using Block = internal::ControlBlockPooled<T, Reset>;
+
+        internal::PoolState<T, Reset>* m_state {nullptr};
+    };
+}
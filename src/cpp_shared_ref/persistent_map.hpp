@@ -0,0 +1,575 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+
+#include "memory.hpp"
+
+namespace sm {
+    namespace internal {
+        inline constexpr unsigned int MAP_BITS {5};
+        inline constexpr std::size_t MAP_MASK {(std::size_t(1) << MAP_BITS) - 1};
+
+        // Nodes at this depth have consumed all the hash bits and store colliding entries in a list
+        inline constexpr unsigned int MAP_COLLISION_SHIFT {((sizeof(std::size_t) * 8 + MAP_BITS - 1) / MAP_BITS) * MAP_BITS};
+
+        inline unsigned int popcount(std::uint32_t value) noexcept {
+            value = value - ((value >> 1) & 0x55555555u);
+            value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+            return static_cast<unsigned int>((((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+        }
+
+        // Entries and children are stored compactly, in the order of their bits in the bitmaps
+        template<typename K, typename V>
+        struct MapNode {
+            std::uint32_t datamap {0};
+            std::uint32_t nodemap {0};
+            std::vector<std::pair<K, V>> entries;
+            std::vector<shared_ref<MapNode>> children;
+        };
+
+        inline std::uint32_t map_bit(std::size_t hash, unsigned int shift) noexcept {
+            return std::uint32_t(1) << ((hash >> shift) & MAP_MASK);
+        }
+
+        inline std::size_t map_index(std::uint32_t bitmap, std::uint32_t bit) noexcept {
+            return popcount(bitmap & (bit - 1));
+        }
+
+        // Hash array mapped trie shared between persistent_map and transient_map
+        // Every mutation copies the nodes that are not uniquely owned, so versions never observe each other
+        template<typename K, typename V, typename Hash, typename KeyEqual>
+        class MapImpl {
+        public:
+            using Node = MapNode<K, V>;
+            using Entry = std::pair<K, V>;
+
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            const V* find(const K& key) const {
+                const std::size_t hash {Hash()(key)};
+                const Node* node {m_root.get()};
+
+                for (unsigned int shift {0}; node != nullptr; shift += MAP_BITS) {
+                    if (shift >= MAP_COLLISION_SHIFT) {
+                        for (const Entry& entry : node->entries) {
+                            if (KeyEqual()(entry.first, key)) {
+                                return &entry.second;
+                            }
+                        }
+
+                        return nullptr;
+                    }
+
+                    const std::uint32_t bit {map_bit(hash, shift)};
+
+                    if (node->datamap & bit) {
+                        const Entry& entry {node->entries[map_index(node->datamap, bit)]};
+
+                        return KeyEqual()(entry.first, key) ? &entry.second : nullptr;
+                    } else if (node->nodemap & bit) {
+                        node = node->children[map_index(node->nodemap, bit)].get();
+                    } else {
+                        return nullptr;
+                    }
+                }
+
+                return nullptr;
+            }
+
+            template<typename Key, typename Value>
+            void insert(Key&& key, Value&& value) {
+                const std::size_t hash {Hash()(key)};
+
+                if (insert(m_root, 0, hash, std::forward<Key>(key), std::forward<Value>(value))) {
+                    m_size++;
+                }
+            }
+
+            void erase(const K& key) {
+                if (find(key) == nullptr) {
+                    return;
+                }
+
+                erase(m_root, 0, Hash()(key), key);
+                m_size--;
+            }
+
+            template<typename F>
+            void for_each(F&& function) const {
+                if (m_root) {
+                    for_each(*m_root, function);
+                }
+            }
+
+            template<typename OnAdded, typename OnRemoved, typename OnChanged>
+            static void diff(const MapImpl& from, const MapImpl& to, OnAdded& added, OnRemoved& removed, OnChanged& changed) {
+                diff(from.m_root.get(), to.m_root.get(), 0, added, removed, changed);
+            }
+        private:
+            // Copy the node, if it's shared with other versions
+            static Node& make_unique(shared_ref<Node>& node) {
+                if (!node) {
+                    node = sm::make_shared<Node>();
+                } else if (!node.unique()) {
+                    node = sm::make_shared<Node>(*node);
+                }
+
+                return *node;
+            }
+
+            template<typename Key, typename Value>
+            static bool insert(shared_ref<Node>& slot, unsigned int shift, std::size_t hash, Key&& key, Value&& value) {
+                Node& node {make_unique(slot)};
+
+                if (shift >= MAP_COLLISION_SHIFT) {
+                    for (Entry& entry : node.entries) {
+                        if (KeyEqual()(entry.first, key)) {
+                            entry.second = std::forward<Value>(value);
+                            return false;
+                        }
+                    }
+
+                    node.entries.emplace_back(std::forward<Key>(key), std::forward<Value>(value));
+                    return true;
+                }
+
+                const std::uint32_t bit {map_bit(hash, shift)};
+
+                if (node.datamap & bit) {
+                    const std::size_t index {map_index(node.datamap, bit)};
+                    Entry& entry {node.entries[index]};
+
+                    if (KeyEqual()(entry.first, key)) {
+                        entry.second = std::forward<Value>(value);
+                        return false;
+                    }
+
+                    // Push both entries one level down
+                    shared_ref<Node> child {
+                        make_pair(
+                            shift + MAP_BITS,
+                            std::move(entry),
+                            Hash()(entry.first),
+                            Entry(std::forward<Key>(key), std::forward<Value>(value)),
+                            hash
+                        )
+                    };
+
+                    node.entries.erase(node.entries.begin() + static_cast<std::ptrdiff_t>(index));
+                    node.datamap ^= bit;
+                    node.nodemap |= bit;
+                    node.children.insert(
+                        node.children.begin() + static_cast<std::ptrdiff_t>(map_index(node.nodemap, bit)),
+                        std::move(child)
+                    );
+
+                    return true;
+                } else if (node.nodemap & bit) {
+                    return insert(
+                        node.children[map_index(node.nodemap, bit)],
+                        shift + MAP_BITS,
+                        hash,
+                        std::forward<Key>(key),
+                        std::forward<Value>(value)
+                    );
+                } else {
+                    node.datamap |= bit;
+                    node.entries.emplace(
+                        node.entries.begin() + static_cast<std::ptrdiff_t>(map_index(node.datamap, bit)),
+                        std::forward<Key>(key),
+                        std::forward<Value>(value)
+                    );
+
+                    return true;
+                }
+            }
+
+            static shared_ref<Node> make_pair(unsigned int shift, Entry&& first, std::size_t first_hash, Entry&& second, std::size_t second_hash) {
+                shared_ref<Node> node {sm::make_shared<Node>()};
+
+                if (shift >= MAP_COLLISION_SHIFT) {
+                    node->entries.push_back(std::move(first));
+                    node->entries.push_back(std::move(second));
+
+                    return node;
+                }
+
+                const std::uint32_t first_bit {map_bit(first_hash, shift)};
+                const std::uint32_t second_bit {map_bit(second_hash, shift)};
+
+                if (first_bit == second_bit) {
+                    node->nodemap = first_bit;
+                    node->children.push_back(
+                        make_pair(shift + MAP_BITS, std::move(first), first_hash, std::move(second), second_hash)
+                    );
+                } else {
+                    node->datamap = first_bit | second_bit;
+
+                    if (first_bit < second_bit) {
+                        node->entries.push_back(std::move(first));
+                        node->entries.push_back(std::move(second));
+                    } else {
+                        node->entries.push_back(std::move(second));
+                        node->entries.push_back(std::move(first));
+                    }
+                }
+
+                return node;
+            }
+
+            // The key must exist
+            static void erase(shared_ref<Node>& slot, unsigned int shift, std::size_t hash, const K& key) {
+                Node& node {make_unique(slot)};
+
+                if (shift >= MAP_COLLISION_SHIFT) {
+                    for (std::size_t i {0}; i < node.entries.size(); i++) {
+                        if (KeyEqual()(node.entries[i].first, key)) {
+                            node.entries.erase(node.entries.begin() + static_cast<std::ptrdiff_t>(i));
+                            return;
+                        }
+                    }
+
+                    return;
+                }
+
+                const std::uint32_t bit {map_bit(hash, shift)};
+
+                if (node.datamap & bit) {
+                    node.entries.erase(node.entries.begin() + static_cast<std::ptrdiff_t>(map_index(node.datamap, bit)));
+                    node.datamap ^= bit;
+
+                    return;
+                }
+
+                const std::size_t index {map_index(node.nodemap, bit)};
+                shared_ref<Node>& child {node.children[index]};
+
+                erase(child, shift + MAP_BITS, hash, key);
+
+                // Keep the trie canonical, by pulling single entries back up
+                if (child->children.empty() && child->entries.size() <= 1) {
+                    if (child->entries.size() == 1) {
+                        Entry entry {std::move(child->entries.front())};
+
+                        node.datamap |= bit;
+                        node.entries.insert(
+                            node.entries.begin() + static_cast<std::ptrdiff_t>(map_index(node.datamap, bit)),
+                            std::move(entry)
+                        );
+                    }
+
+                    node.children.erase(node.children.begin() + static_cast<std::ptrdiff_t>(index));
+                    node.nodemap ^= bit;
+                }
+            }
+
+            template<typename F>
+            static void for_each(const Node& node, F& function) {
+                for (const Entry& entry : node.entries) {
+                    function(entry.first, entry.second);
+                }
+
+                for (const shared_ref<Node>& child : node.children) {
+                    for_each(*child, function);
+                }
+            }
+
+            // Compare an entry that is only in one version with a subtree of the other version
+            template<typename OnAdded, typename OnRemoved, typename OnChanged>
+            static void diff_entry_node(const Entry& entry, const Node& node, bool entry_is_old, OnAdded& added, OnRemoved& removed, OnChanged& changed) {
+                bool found {false};
+
+                auto visit {[&](const K& key, const V& value) {
+                    if (!found && KeyEqual()(key, entry.first)) {
+                        found = true;
+
+                        if (!(value == entry.second)) {
+                            if (entry_is_old) {
+                                changed(key, entry.second, value);
+                            } else {
+                                changed(key, value, entry.second);
+                            }
+                        }
+                    } else if (entry_is_old) {
+                        added(key, value);
+                    } else {
+                        removed(key, value);
+                    }
+                }};
+
+                for_each(node, visit);
+
+                if (!found) {
+                    if (entry_is_old) {
+                        removed(entry.first, entry.second);
+                    } else {
+                        added(entry.first, entry.second);
+                    }
+                }
+            }
+
+            template<typename OnAdded, typename OnRemoved, typename OnChanged>
+            static void diff_collision(const Node& from, const Node& to, OnAdded& added, OnRemoved& removed, OnChanged& changed) {
+                for (const Entry& old_entry : from.entries) {
+                    const Entry* new_entry {nullptr};
+
+                    for (const Entry& entry : to.entries) {
+                        if (KeyEqual()(entry.first, old_entry.first)) {
+                            new_entry = &entry;
+                            break;
+                        }
+                    }
+
+                    if (new_entry == nullptr) {
+                        removed(old_entry.first, old_entry.second);
+                    } else if (!(new_entry->second == old_entry.second)) {
+                        changed(old_entry.first, old_entry.second, new_entry->second);
+                    }
+                }
+
+                for (const Entry& new_entry : to.entries) {
+                    bool found {false};
+
+                    for (const Entry& entry : from.entries) {
+                        if (KeyEqual()(entry.first, new_entry.first)) {
+                            found = true;
+                            break;
+                        }
+                    }
+
+                    if (!found) {
+                        added(new_entry.first, new_entry.second);
+                    }
+                }
+            }
+
+            // Subtrees that are shared between the versions are skipped, so the cost is proportional to the changes
+            template<typename OnAdded, typename OnRemoved, typename OnChanged>
+            static void diff(const Node* from, const Node* to, unsigned int shift, OnAdded& added, OnRemoved& removed, OnChanged& changed) {
+                if (from == to) {
+                    return;
+                }
+
+                if (from == nullptr) {
+                    for_each(*to, added);
+                    return;
+                }
+
+                if (to == nullptr) {
+                    for_each(*from, removed);
+                    return;
+                }
+
+                if (shift >= MAP_COLLISION_SHIFT) {
+                    diff_collision(*from, *to, added, removed, changed);
+                    return;
+                }
+
+                const std::uint32_t bits {from->datamap | from->nodemap | to->datamap | to->nodemap};
+
+                for (unsigned int i {0}; i <= MAP_MASK; i++) {
+                    const std::uint32_t bit {std::uint32_t(1) << i};
+
+                    if (!(bits & bit)) {
+                        continue;
+                    }
+
+                    const Entry* from_entry {from->datamap & bit ? &from->entries[map_index(from->datamap, bit)] : nullptr};
+                    const Entry* to_entry {to->datamap & bit ? &to->entries[map_index(to->datamap, bit)] : nullptr};
+                    const Node* from_child {from->nodemap & bit ? from->children[map_index(from->nodemap, bit)].get() : nullptr};
+                    const Node* to_child {to->nodemap & bit ? to->children[map_index(to->nodemap, bit)].get() : nullptr};
+
+                    if (from_entry != nullptr && to_entry != nullptr) {
+                        if (KeyEqual()(from_entry->first, to_entry->first)) {
+                            if (!(from_entry->second == to_entry->second)) {
+                                changed(from_entry->first, from_entry->second, to_entry->second);
+                            }
+                        } else {
+                            removed(from_entry->first, from_entry->second);
+                            added(to_entry->first, to_entry->second);
+                        }
+                    } else if (from_entry != nullptr) {
+                        if (to_child != nullptr) {
+                            diff_entry_node(*from_entry, *to_child, true, added, removed, changed);
+                        } else {
+                            removed(from_entry->first, from_entry->second);
+                        }
+                    } else if (to_entry != nullptr) {
+                        if (from_child != nullptr) {
+                            diff_entry_node(*to_entry, *from_child, false, added, removed, changed);
+                        } else {
+                            added(to_entry->first, to_entry->second);
+                        }
+                    } else {
+                        diff(from_child, to_child, shift + MAP_BITS, added, removed, changed);
+                    }
+                }
+            }
+
+            shared_ref<Node> m_root;
+            std::size_t m_size {0};
+        };
+    }
+
+    template<typename K, typename V, typename Hash, typename KeyEqual>
+    class transient_map;
+
+    // Immutable hash map with structural sharing, implemented as a hash array mapped trie
+    // Every modification returns a new version that shares the untouched nodes with this one
+    // Lookup, insert and erase are O(log32 n)
+    template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+    class persistent_map {
+    public:
+        using key_type = K;
+        using mapped_type = V;
+
+        // Construct an empty persistent_map
+        persistent_map() noexcept = default;
+
+        // Return a new version with the key mapped to the value
+        // The value of an already existing key is replaced
+        persistent_map insert(K key, V value) const {
+            persistent_map result {*this};
+            result.m_impl.insert(std::move(key), std::move(value));
+
+            return result;
+        }
+
+        // Return a new version without the key
+        persistent_map erase(const K& key) const {
+            persistent_map result {*this};
+            result.m_impl.erase(key);
+
+            return result;
+        }
+
+        // Get a transient_map that starts from this version and mutates its uniquely owned nodes in place
+        transient_map<K, V, Hash, KeyEqual> transient() const noexcept;
+
+        // Get a pointer to the value of the key, or nullptr, if the key doesn't exist
+        const V* find(const K& key) const {
+            return m_impl.find(key);
+        }
+
+        bool contains(const K& key) const {
+            return m_impl.find(key) != nullptr;
+        }
+
+        // Throw std::out_of_range, if the key doesn't exist
+        const V& at(const K& key) const {
+            const V* value {m_impl.find(key)};
+
+            if (value == nullptr) {
+                throw std::out_of_range("Key doesn't exist");
+            }
+
+            return *value;
+        }
+
+        std::size_t size() const noexcept {
+            return m_impl.size();
+        }
+
+        bool empty() const noexcept {
+            return m_impl.size() == 0;
+        }
+
+        // Call the function with every key and value, in no particular order
+        template<typename F>
+        void for_each(F&& function) const {
+            m_impl.for_each(function);
+        }
+
+    private:
+        internal::MapImpl<K, V, Hash, KeyEqual> m_impl;
+
+        friend class transient_map<K, V, Hash, KeyEqual>;
+
+        template<typename K2, typename V2, typename Hash2, typename KeyEqual2, typename OnAdded, typename OnRemoved, typename OnChanged>
+        friend void diff(
+            const persistent_map<K2, V2, Hash2, KeyEqual2>& from,
+            const persistent_map<K2, V2, Hash2, KeyEqual2>& to,
+            OnAdded added,
+            OnRemoved removed,
+            OnChanged changed
+        );
+    };
+
+    // Mutable counterpart of persistent_map, used for batches of modifications
+    // Nodes that are uniquely owned, i.e. their use_count() is 1, are modified in place; shared nodes are copied first
+    template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+    class transient_map {
+    public:
+        // Construct an empty transient_map
+        transient_map() noexcept = default;
+
+        // Map the key to the value, replacing the value of an already existing key
+        void insert(K key, V value) {
+            m_impl.insert(std::move(key), std::move(value));
+        }
+
+        void erase(const K& key) {
+            m_impl.erase(key);
+        }
+
+        // Get an immutable version of the current contents
+        // It shares all the nodes, so further modifications of this object copy them again
+        persistent_map<K, V, Hash, KeyEqual> persistent() const noexcept {
+            persistent_map<K, V, Hash, KeyEqual> result;
+            result.m_impl = m_impl;
+
+            return result;
+        }
+
+        // Get a pointer to the value of the key, or nullptr, if the key doesn't exist
+        const V* find(const K& key) const {
+            return m_impl.find(key);
+        }
+
+        bool contains(const K& key) const {
+            return m_impl.find(key) != nullptr;
+        }
+
+        std::size_t size() const noexcept {
+            return m_impl.size();
+        }
+
+        bool empty() const noexcept {
+            return m_impl.size() == 0;
+        }
+    private:
+        explicit transient_map(const internal::MapImpl<K, V, Hash, KeyEqual>& impl) noexcept
+            : m_impl(impl) {}
+
+        internal::MapImpl<K, V, Hash, KeyEqual> m_impl;
+
+        friend class persistent_map<K, V, Hash, KeyEqual>;
+    };
+
+    template<typename K, typename V, typename Hash, typename KeyEqual>
+    transient_map<K, V, Hash, KeyEqual> persistent_map<K, V, Hash, KeyEqual>::transient() const noexcept {
+        return transient_map<K, V, Hash, KeyEqual>(m_impl);
+    }
+
+    // Report the differences between two versions of a persistent_map, in no particular order
+    // added(key, value), removed(key, value) and changed(key, old_value, new_value) are called for every change
+    // Subtrees shared between the two versions are skipped, so two versions that derive from one another
+    // are compared in time proportional to the number of changes
+    template<typename K, typename V, typename Hash, typename KeyEqual, typename OnAdded, typename OnRemoved, typename OnChanged>
+    void diff(
+        const persistent_map<K, V, Hash, KeyEqual>& from,
+        const persistent_map<K, V, Hash, KeyEqual>& to,
+        OnAdded added,
+        OnRemoved removed,
+        OnChanged changed
+    ) {
+        internal::MapImpl<K, V, Hash, KeyEqual>::diff(from.m_impl, to.m_impl, added, removed, changed);
+    }
+}
@@ -0,0 +1,472 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <new>
+#include <stdexcept>
+#include <iterator>
+#include <memory>  // std::addressof
+
+#include "memory.hpp"
+
+namespace sm {
+    namespace internal {
+        inline constexpr unsigned int VECTOR_BITS {5};
+        inline constexpr std::size_t VECTOR_WIDTH {std::size_t(1) << VECTOR_BITS};
+        inline constexpr std::size_t VECTOR_MASK {VECTOR_WIDTH - 1};
+
+        // Nodes are referenced through shared_ref<VectorNode> and are cast based on their depth in the trie
+        struct VectorNode {};
+
+        template<typename T>
+        struct VectorInner : VectorNode {
+            shared_ref<VectorNode> children[VECTOR_WIDTH];
+        };
+
+        template<typename T>
+        class VectorLeaf : public VectorNode {
+        public:
+            VectorLeaf() noexcept = default;
+
+            // Copy only the first count elements of the other leaf
+            VectorLeaf(const VectorLeaf& other, std::size_t count)
+                : VectorLeaf() {
+                for (std::size_t i {0}; i < count; i++) {
+                    push_back(other[i]);
+                }
+            }
+
+            VectorLeaf(const VectorLeaf& other)
+                : VectorLeaf(other, other.m_count) {}
+
+            VectorLeaf& operator=(const VectorLeaf&) = delete;
+
+            ~VectorLeaf() noexcept {
+                for (std::size_t i {0}; i < m_count; i++) {
+                    (*this)[i].~T();
+                }
+            }
+
+            template<typename U>
+            void push_back(U&& value) {
+                ::new (m_storage + m_count * sizeof(T)) T(std::forward<U>(value));
+                m_count++;
+            }
+
+            T& operator[](std::size_t index) noexcept {
+                return *std::launder(reinterpret_cast<T*>(m_storage + index * sizeof(T)));
+            }
+
+            const T& operator[](std::size_t index) const noexcept {
+                return *std::launder(reinterpret_cast<const T*>(m_storage + index * sizeof(T)));
+            }
+
+            std::size_t size() const noexcept {
+                return m_count;
+            }
+        private:
+            std::size_t m_count {0};
+            alignas(T) unsigned char m_storage[VECTOR_WIDTH * sizeof(T)];
+        };
+
+        // Radix balanced trie with a tail, shared between persistent_vector and transient_vector
+        // Elements are addressed by physical indices; the logical elements are [m_origin, m_end)
+        // Every mutation copies the nodes that are not uniquely owned, so versions never observe each other
+        template<typename T>
+        class VectorImpl {
+        public:
+            using Inner = VectorInner<T>;
+            using Leaf = VectorLeaf<T>;
+
+            std::size_t size() const noexcept {
+                return m_end - m_origin;
+            }
+
+            const T& get(std::size_t index) const noexcept {
+                return leaf_for(m_origin + index)[(m_origin + index) & VECTOR_MASK];
+            }
+
+            // Get the leaf that contains this physical index
+            const Leaf& leaf_for(std::size_t position) const noexcept {
+                if (position >= tail_offset()) {
+                    return *static_cast<const Leaf*>(m_tail.get());
+                }
+
+                const VectorNode* node {m_root.get()};
+
+                for (unsigned int level {m_shift}; level > 0; level -= VECTOR_BITS) {
+                    node = static_cast<const Inner*>(node)->children[(position >> level) & VECTOR_MASK].get();
+                }
+
+                return *static_cast<const Leaf*>(node);
+            }
+
+            template<typename U>
+            void push_back(U&& value) {
+                if (m_end == 0) {
+                    m_tail = sm::make_shared<Leaf>();
+                } else if (m_end - tail_offset() == VECTOR_WIDTH) {
+                    push_tail();
+                    m_tail = sm::make_shared<Leaf>();
+                } else {
+                    make_unique<Leaf>(m_tail);
+                }
+
+                static_cast<Leaf*>(m_tail.get())->push_back(std::forward<U>(value));
+                m_end++;
+            }
+
+            template<typename U>
+            void set(std::size_t index, U&& value) {
+                const std::size_t position {m_origin + index};
+
+                if (position >= tail_offset()) {
+                    make_unique<Leaf>(m_tail);
+                    (*static_cast<Leaf*>(m_tail.get()))[position & VECTOR_MASK] = std::forward<U>(value);
+                    return;
+                }
+
+                make_unique<Inner>(m_root);
+                shared_ref<VectorNode>* slot {&m_root};
+
+                for (unsigned int level {m_shift}; level > 0; level -= VECTOR_BITS) {
+                    slot = &static_cast<Inner*>(slot->get())->children[(position >> level) & VECTOR_MASK];
+
+                    if (level > VECTOR_BITS) {
+                        make_unique<Inner>(*slot);
+                    } else {
+                        make_unique<Leaf>(*slot);
+                    }
+                }
+
+                (*static_cast<Leaf*>(slot->get()))[position & VECTOR_MASK] = std::forward<U>(value);
+            }
+
+            // Keep only the logical elements [begin, end)
+            // Nodes that hold no more logical elements are released
+            void slice(std::size_t begin, std::size_t end) {
+                if (begin == end) {
+                    *this = VectorImpl();
+                    return;
+                }
+
+                const std::size_t new_origin {m_origin + begin};
+                const std::size_t new_end {m_origin + end};
+                const std::size_t new_tail_offset {((new_end - 1) >> VECTOR_BITS) << VECTOR_BITS};
+
+                if (new_end != m_end) {
+                    const Leaf& leaf {leaf_for(new_end - 1)};
+                    m_tail = sm::make_shared<Leaf>(leaf, new_end - new_tail_offset);
+
+                    if (new_tail_offset != tail_offset()) {
+                        m_root = trim_right(m_root, m_shift, new_tail_offset);
+                    }
+                }
+
+                if (new_origin >= new_tail_offset) {
+                    m_root = nullptr;
+                } else if (new_origin != m_origin) {
+                    m_root = trim_left(m_root, m_shift, new_origin);
+                }
+
+                m_origin = new_origin;
+                m_end = new_end;
+
+                // Lower the height of the trie, if the root only uses its first child
+                while (m_shift > VECTOR_BITS && new_tail_offset <= (std::size_t(1) << m_shift)) {
+                    if (m_root) {
+                        shared_ref<VectorNode> child {static_cast<const Inner*>(m_root.get())->children[0]};
+                        m_root = std::move(child);
+                    }
+
+                    m_shift -= VECTOR_BITS;
+                }
+            }
+        private:
+            std::size_t tail_offset() const noexcept {
+                return m_end == 0 ? 0 : ((m_end - 1) >> VECTOR_BITS) << VECTOR_BITS;
+            }
+
+            // Copy the node, if it's shared with other versions
+            template<typename Node>
+            static void make_unique(shared_ref<VectorNode>& node) {
+                if (!node) {
+                    node = sm::make_shared<Node>();
+                } else if (!node.unique()) {
+                    node = sm::make_shared<Node>(*static_cast<const Node*>(node.get()));
+                }
+            }
+
+            // Move the full tail into the trie
+            void push_tail() {
+                const std::size_t position {tail_offset()};
+
+                if (position == std::size_t(1) << (m_shift + VECTOR_BITS)) {
+                    shared_ref<Inner> root {sm::make_shared<Inner>()};
+                    root->children[0] = std::move(m_root);
+                    m_root = std::move(root);
+                    m_shift += VECTOR_BITS;
+                } else {
+                    make_unique<Inner>(m_root);
+                }
+
+                shared_ref<VectorNode>* slot {&m_root};
+
+                for (unsigned int level {m_shift}; level > VECTOR_BITS; level -= VECTOR_BITS) {
+                    slot = &static_cast<Inner*>(slot->get())->children[(position >> level) & VECTOR_MASK];
+                    make_unique<Inner>(*slot);
+                }
+
+                static_cast<Inner*>(slot->get())->children[(position >> VECTOR_BITS) & VECTOR_MASK] = std::move(m_tail);
+            }
+
+            // Release everything at or after limit, relative to the node
+            static shared_ref<VectorNode> trim_right(const shared_ref<VectorNode>& node, unsigned int shift, std::size_t limit) {
+                if (!node || limit == 0) {
+                    return nullptr;
+                }
+
+                if (shift == 0 || limit >= VECTOR_WIDTH << shift) {
+                    return node;
+                }
+
+                const std::size_t last {(limit - 1) >> shift};
+
+                shared_ref<Inner> result {sm::make_shared<Inner>()};
+                const Inner& inner {*static_cast<const Inner*>(node.get())};
+
+                for (std::size_t i {0}; i < last; i++) {
+                    result->children[i] = inner.children[i];
+                }
+
+                result->children[last] = trim_right(inner.children[last], shift - VECTOR_BITS, limit - (last << shift));
+
+                return result;
+            }
+
+            // Release the subtrees that are completely before start, relative to the node
+            static shared_ref<VectorNode> trim_left(const shared_ref<VectorNode>& node, unsigned int shift, std::size_t start) {
+                if (!node || shift == 0) {
+                    return node;
+                }
+
+                const std::size_t first {start >> shift};
+
+                shared_ref<Inner> result {sm::make_shared<Inner>()};
+                const Inner& inner {*static_cast<const Inner*>(node.get())};
+
+                for (std::size_t i {first + 1}; i < VECTOR_WIDTH; i++) {
+                    result->children[i] = inner.children[i];
+                }
+
+                result->children[first] = trim_left(inner.children[first], shift - VECTOR_BITS, start - (first << shift));
+
+                return result;
+            }
+
+            shared_ref<VectorNode> m_root;
+            shared_ref<VectorNode> m_tail;
+            unsigned int m_shift {VECTOR_BITS};
+            std::size_t m_origin {0};
+            std::size_t m_end {0};
+        };
+
+        template<typename T>
+        class VectorIterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            VectorIterator() noexcept = default;
+
+            VectorIterator(const VectorImpl<T>* impl, std::size_t index) noexcept
+                : m_impl(impl), m_index(index) {}
+
+            reference operator*() const noexcept {
+                return m_impl->get(m_index);
+            }
+
+            pointer operator->() const noexcept {
+                return std::addressof(m_impl->get(m_index));
+            }
+
+            VectorIterator& operator++() noexcept {
+                m_index++;
+                return *this;
+            }
+
+            VectorIterator operator++(int) noexcept {
+                VectorIterator result {*this};
+                m_index++;
+                return result;
+            }
+
+            bool operator==(const VectorIterator& other) const noexcept {
+                return m_index == other.m_index;
+            }
+
+            bool operator!=(const VectorIterator& other) const noexcept {
+                return m_index != other.m_index;
+            }
+        private:
+            const VectorImpl<T>* m_impl {nullptr};
+            std::size_t m_index {0};
+        };
+    }
+
+    template<typename T>
+    class transient_vector;
+
+    // Immutable vector with structural sharing
+    // Every modification returns a new version that shares the untouched nodes with this one
+    // Indexing, push_back, set and slice are O(log32 n)
+    template<typename T>
+    class persistent_vector {
+    public:
+        using value_type = T;
+        using const_iterator = internal::VectorIterator<T>;
+
+        // Construct an empty persistent_vector
+        persistent_vector() noexcept = default;
+
+        // Return a new version with the value appended
+        persistent_vector push_back(T value) const {
+            persistent_vector result {*this};
+            result.m_impl.push_back(std::move(value));
+
+            return result;
+        }
+
+        // Return a new version with the element at index replaced
+        // Throw std::out_of_range, if the index is invalid
+        persistent_vector set(std::size_t index, T value) const {
+            check_index(index);
+
+            persistent_vector result {*this};
+            result.m_impl.set(index, std::move(value));
+
+            return result;
+        }
+
+        // Return a new version containing only the elements [begin, end)
+        // Throw std::out_of_range, if the range is invalid
+        persistent_vector slice(std::size_t begin, std::size_t end) const {
+            if (begin > end || end > size()) {
+                throw std::out_of_range("Slice range is out of range");
+            }
+
+            persistent_vector result {*this};
+            result.m_impl.slice(begin, end);
+
+            return result;
+        }
+
+        // Get a transient_vector that starts from this version and mutates its uniquely owned nodes in place
+        transient_vector<T> transient() const noexcept;
+
+        const T& operator[](std::size_t index) const noexcept {
+            return m_impl.get(index);
+        }
+
+        // Throw std::out_of_range, if the index is invalid
+        const T& at(std::size_t index) const {
+            check_index(index);
+
+            return m_impl.get(index);
+        }
+
+        std::size_t size() const noexcept {
+            return m_impl.size();
+        }
+
+        bool empty() const noexcept {
+            return m_impl.size() == 0;
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(&m_impl, 0);
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(&m_impl, m_impl.size());
+        }
+    private:
+        void check_index(std::size_t index) const {
+            if (index >= size()) {
+                throw std::out_of_range("Index is out of range");
+            }
+        }
+
+        internal::VectorImpl<T> m_impl;
+
+        friend class transient_vector<T>;
+    };
+
+    // Mutable counterpart of persistent_vector, used for batches of modifications
+    // Nodes that are uniquely owned, i.e. their use_count() is 1, are modified in place; shared nodes are copied first
+    template<typename T>
+    class transient_vector {
+    public:
+        // Construct an empty transient_vector
+        transient_vector() noexcept = default;
+
+        void push_back(T value) {
+            m_impl.push_back(std::move(value));
+        }
+
+        // Throw std::out_of_range, if the index is invalid
+        void set(std::size_t index, T value) {
+            if (index >= size()) {
+                throw std::out_of_range("Index is out of range");
+            }
+
+            m_impl.set(index, std::move(value));
+        }
+
+        // Keep only the elements [begin, end)
+        // Throw std::out_of_range, if the range is invalid
+        void slice(std::size_t begin, std::size_t end) {
+            if (begin > end || end > size()) {
+                throw std::out_of_range("Slice range is out of range");
+            }
+
+            m_impl.slice(begin, end);
+        }
+
+        // Get an immutable version of the current contents
+        // It shares all the nodes, so further modifications of this object copy them again
+        persistent_vector<T> persistent() const noexcept {
+            persistent_vector<T> result;
+            result.m_impl = m_impl;
+
+            return result;
+        }
+
+        const T& operator[](std::size_t index) const noexcept {
+            return m_impl.get(index);
+        }
+
+        std::size_t size() const noexcept {
+            return m_impl.size();
+        }
+
+        bool empty() const noexcept {
+            return m_impl.size() == 0;
+        }
+    private:
+        explicit transient_vector(const internal::VectorImpl<T>& impl) noexcept
+            : m_impl(impl) {}
+
+        internal::VectorImpl<T> m_impl;
+
+        friend class persistent_vector<T>;
+    };
+
+    template<typename T>
+    transient_vector<T> persistent_vector<T>::transient() const noexcept {
+        return transient_vector<T>(m_impl);
+    }
+}
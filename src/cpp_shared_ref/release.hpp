@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <xmmintrin.h>
+#endif
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    namespace internal {
+        // Objects whose count dropped to zero are kept aside in batches of this size
+        inline constexpr std::size_t RELEASE_BATCH_SIZE {256};
+
+        // How many references ahead the control blocks are prefetched
+        inline constexpr std::size_t RELEASE_PREFETCH_DISTANCE {16};
+
+        inline void prefetch(const void* address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(address, 1);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+            static_cast<void>(address);
+#endif
+        }
+
+        // The blocks are still in cache from being decremented
+        inline void release_batch(ControlBlock* blocks, std::size_t size) noexcept {
+            for (std::size_t i {0}; i < size; i++) {
+                blocks[i].destroy();
+
+                if (--blocks[i].weak_count() == 0) {
+                    blocks[i].dispose();
+                }
+            }
+        }
+    }
+
+    // Release every shared_ref in the range, leaving them empty
+    // Releasing many unrelated references is bound by cache misses on their control blocks, so the blocks are
+    // prefetched a few references ahead of being decremented, and the objects whose count dropped to zero are
+    // destroyed and freed afterwards, in batches small enough to still be in cache
+    // The objects are destroyed in the order of the range, but unlike when resetting the refs one by one, not right
+    // when their count drops to zero: by the time an object's destructor runs, the refs following it in the range may
+    // already be empty, and weak_refs to their objects expired, even though those objects are yet to be destroyed
+    template<typename ForwardIt>
+    void release_all(ForwardIt first, ForwardIt last) noexcept {
+        internal::ControlBlock dying[internal::RELEASE_BATCH_SIZE];
+        std::size_t size {0};
+
+        ForwardIt ahead {first};
+
+        for (std::size_t i {0}; i < internal::RELEASE_PREFETCH_DISTANCE && ahead != last; i++) {
+            ++ahead;
+        }
+
+        for (; first != last; ++first) {
+            if (ahead != last) {
+                const internal::ControlBlock& block {internal::RefAccess::block(*ahead)};
+
+                // The object, which follows the counts in blocks made by make_shared, and the allocator's bookkeeping
+                // next to the block usually extend into the next cache line
+                if (block) {
+                    internal::prefetch(block.base());
+                    internal::prefetch(static_cast<const char*>(block.base()) + internal::CACHE_LINE_SIZE);
+                }
+
+                ++ahead;
+            }
+
+            internal::ControlBlock block {internal::RefAccess::release(*first)};
+
+            if (!block || block.frozen()) {
+                continue;
+            }
+
+            block.trace(internal::TraceKind::Release);
+
+            if (--block.strong_count() == 0) {
+                block.trace(internal::TraceKind::Destroy);
+                dying[size++] = block;
+
+                if (size == internal::RELEASE_BATCH_SIZE) {
+                    internal::release_batch(dying, size);
+                    size = 0;
+                }
+            }
+        }
+
+        internal::release_batch(dying, size);
+    }
+}
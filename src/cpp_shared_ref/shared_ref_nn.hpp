@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <iosfwd>  // std::basic_ostream
+#include <functional>  // std::hash
+#include <utility>
+#include <type_traits>
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    // Object thrown when converting a shared_ref that has no object or no control block to a shared_ref_nn
+    struct bad_null_ref : public std::exception {
+        bad_null_ref() noexcept = default;
+        bad_null_ref(const bad_null_ref&) noexcept = default;
+
+        const char* what() const noexcept override {
+            return "Non-null reference construction failed, as shared pointer is null or owns nothing";
+        }
+    };
+
+    namespace internal {
+        // Let the optimizer rely on the condition
+        inline void assume(bool condition) noexcept {
+#if defined(__clang__)
+            __builtin_assume(condition);
+#elif defined(__GNUC__)
+            if (!condition) {
+                __builtin_unreachable();
+            }
+#elif defined(_MSC_VER)
+            __assume(condition);
+#else
+            static_cast<void>(condition);
+#endif
+        }
+    }
+
+    template<typename T>
+    class shared_ref_nn;
+
+    template<typename T, typename... Args>
+    shared_ref_nn<T> make_shared_nn(Args&&... args);
+
+    // Smart pointer with reference-counting copy semantics, that always points to an object with a control block
+    // It's made only by make_shared_nn or by a checked conversion from shared_ref, so copying and destroying it
+    // update the count without checking for null first, and the stored pointer is known by the optimizer not to be
+    // null
+    // There is no empty state for the destructor to skip, so moving doesn't release the ownership of the source:
+    // move construction increments the count like a copy, and move assignment hands the old reference over to the
+    // source; after auto b {std::move(a)}, the object stays alive until both a and b are destroyed
+    // A moved-from shared_ref_nn still points to an object, but is only meant to be destroyed or assigned to
+    template<typename T>
+    class shared_ref_nn {
+    public:
+        shared_ref_nn() = delete;
+        shared_ref_nn(std::nullptr_t) = delete;
+
+        // Construct a shared_ref_nn that shares ownership with a shared_ref
+        // Throw an exception, if the shared_ref is null or has no control block
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        explicit shared_ref_nn(const shared_ref<U>& ref)
+            : m_ptr(ref.get()), m_block(checked_block(ref)) {
+            m_block.acquire_strong();
+        }
+
+        // Construct a shared_ref_nn that takes ownership from a shared_ref
+        // Throw an exception, if the shared_ref is null or has no control block
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        explicit shared_ref_nn(shared_ref<U>&& ref)
+            : m_ptr(ref.get()), m_block(checked_block(ref)) {
+            internal::RefAccess::release(ref);
+        }
+
+        ~shared_ref_nn() noexcept {
+            m_block.release_strong();
+        }
+
+        shared_ref_nn(const shared_ref_nn& other) noexcept
+            : m_ptr(other.m_ptr), m_block(other.m_block) {
+            m_block.acquire_strong();
+        }
+
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        shared_ref_nn(const shared_ref_nn<U>& other) noexcept
+            : m_ptr(other.m_ptr), m_block(other.m_block) {
+            m_block.acquire_strong();
+        }
+
+        // Same as copying, as the source cannot be left empty, so it keeps its reference until destroyed
+        shared_ref_nn(shared_ref_nn&& other) noexcept
+            : shared_ref_nn(static_cast<const shared_ref_nn&>(other)) {}
+
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        shared_ref_nn(shared_ref_nn<U>&& other) noexcept
+            : shared_ref_nn(static_cast<const shared_ref_nn<U>&>(other)) {}
+
+        // The new reference is taken before the old one is dropped, so self-assignment is safe
+        shared_ref_nn& operator=(const shared_ref_nn& other) noexcept {
+            internal::ControlBlock block {other.m_block};
+            block.acquire_strong();
+            m_block.release_strong();
+
+            m_ptr = other.m_ptr;
+            m_block = block;
+
+            return *this;
+        }
+
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        shared_ref_nn& operator=(const shared_ref_nn<U>& other) noexcept {
+            internal::ControlBlock block {other.m_block};
+            block.acquire_strong();
+            m_block.release_strong();
+
+            m_ptr = other.m_ptr;
+            m_block = block;
+
+            return *this;
+        }
+
+        // The source gets the old reference, which it drops when destroyed
+        shared_ref_nn& operator=(shared_ref_nn&& other) noexcept {
+            swap(other);
+
+            return *this;
+        }
+
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        shared_ref_nn& operator=(shared_ref_nn<U>&& other) noexcept {
+            return *this = static_cast<const shared_ref_nn<U>&>(other);
+        }
+
+        // Get a shared_ref that shares ownership with this shared_ref_nn, which also makes a weak_ref out of it
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<T*, U*>>>
+        operator shared_ref<U>() const noexcept {
+            internal::ControlBlock block {m_block};
+            block.acquire_strong();
+
+            return internal::RefAccess::adopt<U>(get(), block);
+        }
+
+        // Get the stored object pointer, which is never null
+        T* get() const noexcept {
+            internal::assume(m_ptr != nullptr);
+
+            return m_ptr;
+        }
+
+        T& operator*() const noexcept {
+            return *get();
+        }
+
+        T* operator->() const noexcept {
+            return get();
+        }
+
+        // Get the reference count
+        std::size_t use_count() const noexcept {
+            return m_block.strong_count() & ~internal::ControlBlock::FROZEN;
+        }
+
+        // Check if the managed object has only one reference
+        // A frozen object is never unique
+        bool unique() const noexcept {
+            return m_block.strong_count() == 1;
+        }
+
+        // Always true
+        explicit operator bool() const noexcept {
+            return true;
+        }
+
+        template<typename U>
+        bool owner_before(const shared_ref_nn<U>& other) const noexcept {
+            return m_block.base() < other.m_block.base();
+        }
+
+        void swap(shared_ref_nn& other) noexcept {
+            std::swap(m_ptr, other.m_ptr);
+            std::swap(m_block, other.m_block);
+        }
+    private:
+        shared_ref_nn(T* ptr, internal::ControlBlock block) noexcept
+            : m_ptr(ptr), m_block(block) {}
+
+        template<typename U>
+        static internal::ControlBlock checked_block(const shared_ref<U>& ref) {
+            const internal::ControlBlock& block {internal::RefAccess::block(ref)};
+
+            if (ref.get() == nullptr || !block) {
+                throw bad_null_ref();
+            }
+
+            return block;
+        }
+
+        T* m_ptr;
+        internal::ControlBlock m_block;
+
+        template<typename U>
+        friend class shared_ref_nn;
+
+        template<typename U, typename... Args>
+        friend shared_ref_nn<U> make_shared_nn(Args&&... args);
+    };
+
+    // Construct a new shared_ref_nn, the same way as make_shared
+    template<typename T, typename... Args>
+    shared_ref_nn<T> make_shared_nn(Args&&... args) {
+        shared_ref<T> ref {sm::make_shared<T>(std::forward<Args>(args)...)};
+        T* const ptr {ref.get()};
+
+        return shared_ref_nn<T>(ptr, internal::RefAccess::release(ref));
+    }
+}
+
+// Comparison operators with another shared_ref_nn or with a shared_ref
+
+template<typename T, typename U>
+bool operator==(const sm::shared_ref_nn<T>& lhs, const sm::shared_ref_nn<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U>
+bool operator!=(const sm::shared_ref_nn<T>& lhs, const sm::shared_ref_nn<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template<typename T, typename U>
+bool operator<(const sm::shared_ref_nn<T>& lhs, const sm::shared_ref_nn<U>& rhs) noexcept {
+    return lhs.get() < rhs.get();
+}
+
+template<typename T, typename U>
+bool operator==(const sm::shared_ref_nn<T>& lhs, const sm::shared_ref<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U>
+bool operator==(const sm::shared_ref<T>& lhs, const sm::shared_ref_nn<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U>
+bool operator!=(const sm::shared_ref_nn<T>& lhs, const sm::shared_ref<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template<typename T, typename U>
+bool operator!=(const sm::shared_ref<T>& lhs, const sm::shared_ref_nn<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+// Write the stored pointer of the shared_ref_nn object to the output stream
+template<typename CharType, typename Traits, typename T>
+std::basic_ostream<CharType, Traits>& operator<<(std::basic_ostream<CharType, Traits>& stream, const sm::shared_ref_nn<T>& ref) {
+    stream << ref.get();
+
+    return stream;
+}
+
+namespace std {
+    // Swap two shared_ref_nn objects
+    template<typename T>
+    void swap(sm::shared_ref_nn<T>& lhs, sm::shared_ref_nn<T>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // Get the hash of the shared_ref_nn object, i.e. the hash of the stored pointer
+    template<typename T>
+    struct hash<sm::shared_ref_nn<T>> {
+        size_t operator()(const sm::shared_ref_nn<T>& ref) const noexcept {
+            return hash<T*>()(ref.get());
+        }
+    };
+}
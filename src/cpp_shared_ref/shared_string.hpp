@@ -0,0 +1,281 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <iosfwd>  // std::basic_ostream
+#include <functional>  // std::hash
+#include <new>
+#include <utility>
+
+#include "internal/control_block.hpp"
+
+namespace sm {
+    namespace internal {
+        // Control block followed by the length, the hash and the null-terminated characters of a shared_string,
+        // in the same allocation
+        class ControlBlockString final : public ControlBlockBase {
+        public:
+            static ControlBlockString* create(std::string_view string) {
+                const auto block {
+                    ::new (::operator new(sizeof(ControlBlockString) + string.size() + 1)) ControlBlockString(string)
+                };
+
+                std::memcpy(block->data(), string.data(), string.size());
+                block->data()[string.size()] = '\0';
+
+                return block;
+            }
+
+            void destroy() const noexcept override {}
+
+            void* get_deleter(TypeId) noexcept override {
+                return nullptr;
+            }
+
+            char* data() noexcept {
+                return reinterpret_cast<char*>(this + 1);
+            }
+
+            std::size_t hash() const noexcept {
+                return m_hash;
+            }
+
+            // Called by the virtual destructor, as the block has been allocated by create
+            static void operator delete(void* ptr) noexcept {
+                ::operator delete(ptr);
+            }
+        private:
+            explicit ControlBlockString(std::string_view string) noexcept
+                : m_hash(std::hash<std::string_view>()(string)) {}
+
+            std::size_t m_hash {};
+        };
+    }
+
+    // Immutable, reference-counted string
+    // Long strings are allocated together with their control block and their hash, which is computed once, so
+    // copies are O(1) and only increment a count, while short strings are stored inline and copied by value,
+    // without any allocation
+    class shared_string {
+    public:
+        // Construct an empty shared_string
+        shared_string() noexcept {
+            set_small_size(0);
+        }
+
+        // Construct a shared_string with a copy of these characters
+        explicit shared_string(std::string_view string) {
+            if (string.size() <= SMALL_SIZE) {
+                std::memcpy(m_storage.small, string.data(), string.size());
+                set_small_size(string.size());
+            } else {
+                m_storage.large.block = internal::ControlBlockString::create(string);
+                m_storage.large.size = string.size();
+                set_tag(LARGE);
+            }
+        }
+
+        explicit shared_string(const char* string)
+            : shared_string(std::string_view(string)) {}
+
+        ~shared_string() noexcept {
+            destroy_this();
+        }
+
+        shared_string(const shared_string& other) noexcept
+            : m_storage(other.m_storage) {
+            if (other.large()) {
+                block().acquire_strong();
+            }
+        }
+
+        shared_string& operator=(const shared_string& other) noexcept {
+            shared_string(other).swap(*this);
+
+            return *this;
+        }
+
+        shared_string(shared_string&& other) noexcept
+            : m_storage(other.m_storage) {
+            other.set_small_size(0);
+        }
+
+        shared_string& operator=(shared_string&& other) noexcept {
+            shared_string(std::move(other)).swap(*this);
+
+            return *this;
+        }
+
+        // Get the null-terminated characters
+        const char* data() const noexcept {
+            return large() ? m_storage.large.block->data() : m_storage.small;
+        }
+
+        const char* c_str() const noexcept {
+            return data();
+        }
+
+        std::size_t size() const noexcept {
+            return large() ? m_storage.large.size : SMALL_SIZE - tag();
+        }
+
+        std::size_t length() const noexcept {
+            return size();
+        }
+
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        const char* begin() const noexcept {
+            return data();
+        }
+
+        const char* end() const noexcept {
+            return data() + size();
+        }
+
+        char operator[](std::size_t index) const noexcept {
+            return data()[index];
+        }
+
+        std::string_view view() const noexcept {
+            return std::string_view(data(), size());
+        }
+
+        operator std::string_view() const noexcept {
+            return view();
+        }
+
+        // Get the hash of the characters, the same as that of std::string_view
+        // It's cached for long strings and computed every time for short ones
+        std::size_t hash() const noexcept {
+            return large() ? m_storage.large.block->hash() : std::hash<std::string_view>()(view());
+        }
+
+        void swap(shared_string& other) noexcept {
+            std::swap(m_storage, other.m_storage);
+        }
+
+        // Check if both strings are the same
+        // Long strings sharing the same characters are equal right away, and long strings with different hashes
+        // are different right away
+        friend bool operator==(const shared_string& lhs, const shared_string& rhs) noexcept {
+            if (lhs.large() && rhs.large()) {
+                if (lhs.m_storage.large.block == rhs.m_storage.large.block) {
+                    return true;
+                }
+
+                if (lhs.m_storage.large.block->hash() != rhs.m_storage.large.block->hash()) {
+                    return false;
+                }
+            }
+
+            return lhs.view() == rhs.view();
+        }
+
+        friend bool operator!=(const shared_string& lhs, const shared_string& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const shared_string& lhs, const shared_string& rhs) noexcept {
+            return lhs.view() < rhs.view();
+        }
+
+        friend bool operator>(const shared_string& lhs, const shared_string& rhs) noexcept {
+            return lhs.view() > rhs.view();
+        }
+
+        friend bool operator<=(const shared_string& lhs, const shared_string& rhs) noexcept {
+            return lhs.view() <= rhs.view();
+        }
+
+        friend bool operator>=(const shared_string& lhs, const shared_string& rhs) noexcept {
+            return lhs.view() >= rhs.view();
+        }
+
+        friend bool operator==(const shared_string& lhs, std::string_view rhs) noexcept {
+            return lhs.view() == rhs;
+        }
+
+        friend bool operator==(std::string_view lhs, const shared_string& rhs) noexcept {
+            return lhs == rhs.view();
+        }
+
+        friend bool operator!=(const shared_string& lhs, std::string_view rhs) noexcept {
+            return lhs.view() != rhs;
+        }
+
+        friend bool operator!=(std::string_view lhs, const shared_string& rhs) noexcept {
+            return lhs != rhs.view();
+        }
+    private:
+        struct Large {
+            internal::ControlBlockString* block;
+            std::size_t size;
+        };
+
+        // Short strings fill the whole object, except for the last byte, which is the tag
+        // The tag is the number of unused characters, which is zero, i.e. the null terminator, for a full string
+        static constexpr std::size_t SMALL_SIZE {sizeof(Large) + sizeof(void*) - 1};
+        static constexpr unsigned char LARGE {0xFF};
+
+        union Storage {
+            char small[SMALL_SIZE + 1];
+            Large large;
+        };
+
+        bool large() const noexcept {
+            return tag() == LARGE;
+        }
+
+        unsigned char tag() const noexcept {
+            return reinterpret_cast<const unsigned char*>(&m_storage)[SMALL_SIZE];
+        }
+
+        void set_tag(unsigned char tag) noexcept {
+            reinterpret_cast<unsigned char*>(&m_storage)[SMALL_SIZE] = tag;
+        }
+
+        void set_small_size(std::size_t size) noexcept {
+            m_storage.small[size] = '\0';
+            set_tag(static_cast<unsigned char>(SMALL_SIZE - size));
+        }
+
+        internal::ControlBlock block() const noexcept {
+            return internal::ControlBlock(internal::AdoptTag(), m_storage.large.block);
+        }
+
+        void destroy_this() noexcept {
+            if (large()) {
+                block().release_strong();
+            }
+        }
+
+        Storage m_storage;
+    };
+}
+
+// Write the characters of the shared_string object to the output stream
+template<typename CharType, typename Traits>
+std::basic_ostream<CharType, Traits>& operator<<(std::basic_ostream<CharType, Traits>& stream, const sm::shared_string& string) {
+    stream << string.view();
+
+    return stream;
+}
+
+namespace std {
+    // Swap two shared_string objects
+    inline void swap(sm::shared_string& lhs, sm::shared_string& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // Get the hash of the shared_string object, i.e. the hash of its characters, which is cached for long strings
+    template<>
+    struct hash<sm::shared_string> {
+        std::size_t operator()(const sm::shared_string& string) const noexcept {
+            return string.hash();
+        }
+    };
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <functional>  // std::invoke
+#include <type_traits>
+#include <new>
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    // Identifier of a receiver connected to a signal
+    using connection = std::size_t;
+
+    // List of receivers that are called when the signal is emitted
+    // The receivers are only observed, like with weak_refs: once a receiver is destroyed, it's skipped and its slot is
+    // removed during the next emission, without a separate cleanup pass
+    // The slots are stored contiguously; connecting and disconnecting is allowed from within the receivers while
+    // emitting, in which case new receivers are only called from the next emission on
+    // The signal must not be destroyed or moved while emitting
+    template<typename... Args>
+    class signal {
+    public:
+        // Construct a signal without receivers
+        signal() noexcept = default;
+
+        ~signal() noexcept = default;
+
+        signal(const signal&) = delete;
+        signal& operator=(const signal&) = delete;
+        signal(signal&&) noexcept = default;
+        signal& operator=(signal&&) noexcept = default;
+
+        // Connect a receiver, which is called as std::invoke(function, *receiver, args...)
+        // The function can be a pointer to a member function, or a trivially copyable callable small enough to fit
+        // inside the slot, like a lambda capturing a pointer or two
+        template<typename T, typename F>
+        connection connect(const shared_ref<T>& receiver, F function) {
+            static_assert(std::is_invocable_v<const F&, T&, Args&...>, "Function must be callable with the arguments");
+            static_assert(sizeof(F) <= sizeof(Storage), "Function must fit in the slot");
+            static_assert(alignof(F) <= alignof(Storage), "Function must fit in the slot");
+            static_assert(std::is_trivially_copyable_v<F>, "Function must be trivially copyable");
+
+            Slot slot;
+            slot.object = const_cast<std::remove_cv_t<T>*>(receiver.get());
+            slot.call = &call_receiver<T, F>;
+            slot.id = m_next_id++;
+            ::new (static_cast<void*>(slot.storage.bytes)) F(function);
+
+            internal::ControlBlock block {internal::RefAccess::block(receiver)};
+
+            if (block) {
+                block.acquire_weak();
+                slot.block = internal::WeakBlock(block);
+            }
+
+            const connection id {slot.id};
+            m_slots.push_back(std::move(slot));
+
+            return id;
+        }
+
+        // Disconnect a receiver, so that it's not called anymore
+        void disconnect(connection id) noexcept {
+            for (Slot& slot : m_slots) {
+                if (slot.id == id && slot.call != nullptr) {
+                    slot.clear();
+                    break;
+                }
+            }
+
+            if (m_emitting == 0) {
+                compact();
+            } else {
+                m_dirty = true;
+            }
+        }
+
+        // Disconnect all the receivers
+        void disconnect_all() noexcept {
+            for (Slot& slot : m_slots) {
+                slot.clear();
+            }
+
+            if (m_emitting == 0) {
+                m_slots.clear();
+            } else {
+                m_dirty = true;
+            }
+        }
+
+        // Call every receiver that is still alive, in the order they were connected
+        // Every receiver is locked, i.e. kept alive, for the duration of its call, like with weak_ref::lock
+        void emit(Args... args) {
+            emit_slots<true>(args...);
+        }
+
+        void operator()(Args... args) {
+            emit_slots<true>(args...);
+        }
+
+        // Same as emit, but the receivers are not locked
+        // This is for when the emitter guarantees that no receiver is destroyed during the emission, saving two
+        // reference count updates per receiver
+        void emit_unguarded(Args... args) {
+            emit_slots<false>(args...);
+        }
+
+        // Get the number of connected receivers, including the ones that have been destroyed, but not removed yet
+        std::size_t size() const noexcept {
+            std::size_t result {0};
+
+            for (const Slot& slot : m_slots) {
+                result += slot.call != nullptr ? 1 : 0;
+            }
+
+            return result;
+        }
+
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+    private:
+        struct Storage {
+            alignas(void*) unsigned char bytes[3 * sizeof(void*)];
+        };
+
+        using Call = void(*)(void* object, const Storage& storage, Args&... args);
+
+        struct Slot {
+            Slot() noexcept = default;
+
+            Slot(Slot&& other) noexcept
+                : block(std::move(other.block)), object(other.object), call(other.call), storage(other.storage),
+                id(other.id) {
+                other.call = nullptr;
+            }
+
+            Slot& operator=(Slot&& other) noexcept {
+                block = std::move(other.block);
+                object = other.object;
+                call = other.call;
+                storage = other.storage;
+                id = other.id;
+                other.call = nullptr;
+
+                return *this;
+            }
+
+            bool dead() const noexcept {
+                return call == nullptr || block.expired();
+            }
+
+            void clear() noexcept {
+                block = internal::WeakBlock();
+                call = nullptr;
+            }
+
+            internal::WeakBlock block;
+            void* object {nullptr};
+            Call call {nullptr};
+            Storage storage {};
+            connection id {0};
+        };
+
+        template<typename T, typename F>
+        static void call_receiver(void* object, const Storage& storage, Args&... args) {
+            const F& function {*std::launder(reinterpret_cast<const F*>(storage.bytes))};
+            std::invoke(function, *static_cast<T*>(object), args...);
+        }
+
+        // Slots are accessed by index, as receivers may connect new ones, which are appended and not called until the
+        // next emission; dead slots are only skipped and then removed all at once by the outermost emission
+        template<bool Lock>
+        void emit_slots(Args&... args) {
+            struct Guard {
+                ~Guard() noexcept {
+                    if (--self.m_emitting == 0 && self.m_dirty) {
+                        self.compact();
+                        self.m_dirty = false;
+                    }
+                }
+
+                signal& self;
+            } guard {*this};
+
+            m_emitting++;
+
+            const std::size_t size {m_slots.size()};
+
+            for (std::size_t i {0}; i < size; i++) {
+                if (m_slots[i].dead()) {
+                    m_dirty = true;
+                    continue;
+                }
+
+                // Copied, as the slot may be disconnected or moved during the call
+                const Storage storage {m_slots[i].storage};
+                void* const object {m_slots[i].object};
+                const Call function {m_slots[i].call};
+
+                if constexpr (Lock) {
+                    internal::ControlBlock block {m_slots[i].block.get()};
+
+                    if (block) {
+                        block.acquire_strong();
+                    }
+
+                    const internal::SharedBlock locked {block};
+                    function(object, storage, args...);
+                } else {
+                    function(object, storage, args...);
+                }
+            }
+        }
+
+        void compact() noexcept {
+            m_slots.erase(
+                std::remove_if(m_slots.begin(), m_slots.end(), [](const Slot& slot) { return slot.dead(); }),
+                m_slots.end()
+            );
+        }
+
+        std::vector<Slot> m_slots;
+        connection m_next_id {0};
+        std::size_t m_emitting {0};
+        bool m_dirty {false};  // Whether there are dead slots to remove after emitting
+    };
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <ostream>
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+#ifdef _WIN32
+    // Keep windows.h from defining the min and max macros and pulling in the rarely used headers, without changing
+    // those settings for the code that includes this header
+    #ifndef NOMINMAX
+        #define NOMINMAX
+        #define CPP_SHARED_REF_UNDEF_NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+        #define CPP_SHARED_REF_UNDEF_WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    #ifdef CPP_SHARED_REF_UNDEF_NOMINMAX
+        #undef NOMINMAX
+        #undef CPP_SHARED_REF_UNDEF_NOMINMAX
+    #endif
+    #ifdef CPP_SHARED_REF_UNDEF_WIN32_LEAN_AND_MEAN
+        #undef WIN32_LEAN_AND_MEAN
+        #undef CPP_SHARED_REF_UNDEF_WIN32_LEAN_AND_MEAN
+    #endif
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "memory.hpp"
+
+namespace sm {
+    // Exception thrown when a snapshot cannot be written or mapped
+    class bad_snapshot : public std::exception {
+    public:
+        explicit bad_snapshot(const char* message) noexcept
+            : m_message(message) {}
+
+        const char* what() const noexcept override {
+            return m_message;
+        }
+    private:
+        const char* m_message {};
+    };
+
+    // Pointer stored inside snapshot objects, as an offset relative to itself, so that it stays valid wherever the
+    // snapshot is mapped
+    // A pointer to the very address of itself cannot be represented, as that is null
+    // It's trivially copyable, as snapshot objects are copied byte by byte, so a copy keeps the offset and points
+    // somewhere else; a snapshot_ptr is only set in place, by assigning the target to it
+    template<typename T>
+    class snapshot_ptr {
+    public:
+        snapshot_ptr() noexcept = default;
+
+        snapshot_ptr(std::nullptr_t) noexcept {}
+
+        snapshot_ptr(const snapshot_ptr&) noexcept = default;
+        snapshot_ptr& operator=(const snapshot_ptr&) noexcept = default;
+
+        // Point to the target from where this snapshot_ptr is
+        snapshot_ptr& operator=(const T* target) noexcept {
+            set(target);
+
+            return *this;
+        }
+
+        snapshot_ptr& operator=(std::nullptr_t) noexcept {
+            m_offset = 0;
+
+            return *this;
+        }
+
+        const T* get() const noexcept {
+            if (m_offset == 0) {
+                return nullptr;
+            }
+
+            return reinterpret_cast<const T*>(reinterpret_cast<const char*>(this) + m_offset);
+        }
+
+        const T& operator*() const noexcept {
+            return *get();
+        }
+
+        const T* operator->() const noexcept {
+            return get();
+        }
+
+        explicit operator bool() const noexcept {
+            return m_offset != 0;
+        }
+    private:
+        void set(const T* target) noexcept {
+            if (target == nullptr) {
+                m_offset = 0;
+            } else {
+                m_offset = reinterpret_cast<const char*>(target) - reinterpret_cast<const char*>(this);
+            }
+        }
+
+        std::ptrdiff_t m_offset {0};
+    };
+
+    static_assert(std::is_trivially_copyable_v<snapshot_ptr<int>>, "snapshot_ptr must be copyable byte by byte");
+
+    // Contiguous array stored inside snapshot objects
+    // Like snapshot_ptr, it's only set in place
+    template<typename T>
+    class snapshot_span {
+    public:
+        snapshot_span() noexcept = default;
+
+        // View the array from where this snapshot_span is
+        void assign(const T* data, std::size_t size) noexcept {
+            m_data = data;
+            m_size = size;
+        }
+
+        const T* begin() const noexcept {
+            return m_data.get();
+        }
+
+        const T* end() const noexcept {
+            return m_data.get() + m_size;
+        }
+
+        const T* data() const noexcept {
+            return m_data.get();
+        }
+
+        const T& operator[](std::size_t index) const noexcept {
+            return m_data.get()[index];
+        }
+
+        std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        bool empty() const noexcept {
+            return m_size == 0;
+        }
+    private:
+        snapshot_ptr<T> m_data;
+        std::size_t m_size {0};
+    };
+
+    static_assert(std::is_trivially_copyable_v<snapshot_span<int>>, "snapshot_span must be copyable byte by byte");
+
+    // Position of an object inside a snapshot_builder, which stays the same when the builder grows
+    template<typename T>
+    struct snapshot_offset {
+        std::size_t value {};
+    };
+
+    namespace internal {
+        inline constexpr std::uint32_t SNAPSHOT_MAGIC {0x534E4D53};
+        inline constexpr std::uint32_t SNAPSHOT_VERSION {1};
+
+        // Objects are aligned to at most this, which is what both operator new and the mapping guarantee
+        inline constexpr std::size_t SNAPSHOT_ALIGNMENT {__STDCPP_DEFAULT_NEW_ALIGNMENT__};
+
+        struct alignas(SNAPSHOT_ALIGNMENT) SnapshotHeader {
+            std::uint32_t magic {};
+            std::uint32_t version {};
+            std::uint64_t size {};
+            std::uint64_t root {};
+        };
+
+        // Objects are copied byte by byte, both when the builder grows and when mapped, so they may only refer
+        // to each other through snapshot_ptrs and snapshot_spans and must not own anything
+        template<typename T>
+        inline constexpr bool is_snapshot_object_v {
+            std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T> && alignof(T) <= SNAPSHOT_ALIGNMENT
+        };
+
+        // Owner of a mapped file, destroyed by the control block of the snapshot
+        struct SnapshotMapping {
+            void operator()(const void* address) const noexcept {
+#ifdef _WIN32
+                UnmapViewOfFile(address);
+#else
+                munmap(const_cast<void*>(address), size);
+#endif
+            }
+
+            std::size_t size {};
+        };
+    }
+
+    // Builder of snapshot files, in which the objects are laid out exactly as they are in memory
+    // Objects are accessed by their offsets, as references to them are invalidated when the builder grows
+    class snapshot_builder {
+    public:
+        snapshot_builder() {
+            m_buffer.resize(sizeof(internal::SnapshotHeader));
+        }
+
+        // Construct a new object at the end of the snapshot and get its offset
+        template<typename T, typename... Args>
+        snapshot_offset<T> emplace(Args&&... args) {
+            static_assert(
+                internal::is_snapshot_object_v<T>,
+                "Type must be trivially copyable, trivially destructible and not over-aligned"
+            );
+
+            const std::size_t offset {allocate(sizeof(T), alignof(T))};
+            ::new (static_cast<void*>(m_buffer.data() + offset)) T(std::forward<Args>(args)...);
+
+            return snapshot_offset<T> {offset};
+        }
+
+        // Construct count value initialized objects contiguously and get the offset of the first one
+        template<typename T>
+        snapshot_offset<T> emplace_array(std::size_t count) {
+            static_assert(
+                internal::is_snapshot_object_v<T>,
+                "Type must be trivially copyable, trivially destructible and not over-aligned"
+            );
+
+            const std::size_t offset {allocate(sizeof(T) * count, alignof(T))};
+
+            for (std::size_t i {0}; i < count; i++) {
+                ::new (static_cast<void*>(m_buffer.data() + offset + sizeof(T) * i)) T();
+            }
+
+            return snapshot_offset<T> {offset};
+        }
+
+        // Get an object by its offset; the reference is valid until the next object is constructed
+        template<typename T>
+        T& operator[](snapshot_offset<T> offset) noexcept {
+            return *std::launder(reinterpret_cast<T*>(m_buffer.data() + offset.value));
+        }
+
+        // Write the snapshot with this object as its root
+        // Throw an exception, if the stream fails
+        void write(std::ostream& stream, snapshot_offset<void> root) {
+            internal::SnapshotHeader header;
+            header.magic = internal::SNAPSHOT_MAGIC;
+            header.version = internal::SNAPSHOT_VERSION;
+            header.size = m_buffer.size();
+            header.root = root.value;
+
+            std::memcpy(m_buffer.data(), &header, sizeof(header));
+
+            stream.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+            stream.flush();
+
+            if (!stream) {
+                throw bad_snapshot("Could not write the snapshot to the stream");
+            }
+        }
+
+        template<typename T>
+        void write(std::ostream& stream, snapshot_offset<T> root) {
+            write(stream, snapshot_offset<void> {root.value});
+        }
+
+        // Get the size of the snapshot in bytes
+        std::size_t size() const noexcept {
+            return m_buffer.size();
+        }
+    private:
+        std::size_t allocate(std::size_t size, std::size_t alignment) {
+            const std::size_t offset {(m_buffer.size() + alignment - 1) / alignment * alignment};
+            m_buffer.resize(offset + size);
+
+            return offset;
+        }
+
+        std::vector<unsigned char> m_buffer;
+    };
+
+    // Map a snapshot file read-only and get its root object
+    // The objects are used in place, without being copied or allocated; every shared_ref into the snapshot shares
+    // one control block, which unmaps the file when the last of them is gone, so references to the other objects
+    // are made with the aliasing constructor, e.g. shared_ref<const U>(root, root->child.get())
+    // Copying those references writes only to the control block, never to the mapped pages
+    // The file is trusted to contain objects of the types it is read with
+    template<typename T>
+    shared_ref<const T> map_snapshot(const char* path) {
+        static_assert(
+            internal::is_snapshot_object_v<T>,
+            "Type must be trivially copyable, trivially destructible and not over-aligned"
+        );
+
+        const void* address {nullptr};
+        std::size_t size {0};
+
+#ifdef _WIN32
+        const HANDLE file {
+            CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)
+        };
+
+        if (file == INVALID_HANDLE_VALUE) {
+            throw bad_snapshot("Could not open the snapshot file");
+        }
+
+        LARGE_INTEGER file_size {};
+
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < LONGLONG(sizeof(internal::SnapshotHeader))) {
+            CloseHandle(file);
+            throw bad_snapshot("Snapshot file is too small");
+        }
+
+        const HANDLE mapping {CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+        CloseHandle(file);
+
+        if (mapping == nullptr) {
+            throw bad_snapshot("Could not map the snapshot file");
+        }
+
+        address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+
+        if (address == nullptr) {
+            throw bad_snapshot("Could not map the snapshot file");
+        }
+
+        size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+        const int file {open(path, O_RDONLY)};
+
+        if (file < 0) {
+            throw bad_snapshot("Could not open the snapshot file");
+        }
+
+        struct stat status {};
+
+        if (fstat(file, &status) < 0 || status.st_size < static_cast<off_t>(sizeof(internal::SnapshotHeader))) {
+            close(file);
+            throw bad_snapshot("Snapshot file is too small");
+        }
+
+        size = static_cast<std::size_t>(status.st_size);
+        void* result {mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0)};
+        close(file);
+
+        if (result == MAP_FAILED) {
+            throw bad_snapshot("Could not map the snapshot file");
+        }
+
+        address = result;
+#endif
+
+        // The one allocation of the snapshot; if it fails, the mapping is released by the deleter
+        const shared_ref<const internal::SnapshotHeader> header {
+            static_cast<const internal::SnapshotHeader*>(address), internal::SnapshotMapping {size}
+        };
+
+        if (header->magic != internal::SNAPSHOT_MAGIC) {
+            throw bad_snapshot("File is not a snapshot, or was written with a different byte order");
+        }
+
+        if (header->version != internal::SNAPSHOT_VERSION) {
+            throw bad_snapshot("Snapshot version is not supported");
+        }
+
+        if (header->size != size) {
+            throw bad_snapshot("Snapshot file is truncated");
+        }
+
+        if (sizeof(T) > size || header->root < sizeof(internal::SnapshotHeader) || header->root > size - sizeof(T)
+                || header->root % alignof(T) != 0) {
+            throw bad_snapshot("Snapshot root is invalid");
+        }
+
+        const auto root {reinterpret_cast<const T*>(static_cast<const char*>(address) + header->root)};
+
+        return shared_ref<const T>(header, root);
+    }
+}
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "internal/control_block.hpp"
+#include "internal/trace.hpp"
+
+namespace sm {
+    // Exception thrown when the trace file cannot be written
+    class bad_trace : public std::exception {
+    public:
+        explicit bad_trace(const char* message) noexcept
+            : m_message(message) {}
+
+        const char* what() const noexcept override {
+            return m_message;
+        }
+    private:
+        const char* m_message {};
+    };
+
+    namespace internal {
+        inline const char* trace_kind_name(TraceKind kind) noexcept {
+            switch (kind) {
+                case TraceKind::Create:
+                    return "create";
+                case TraceKind::Copy:
+                case TraceKind::WeakCopy:
+                    return "copy";
+                case TraceKind::Release:
+                case TraceKind::WeakRelease:
+                    return "release";
+                case TraceKind::Destroy:
+                    return "destroy";
+                case TraceKind::Lock:
+                    return "lock";
+                case TraceKind::Mark:
+                    break;
+            }
+
+            return "mark";
+        }
+
+        inline const char* trace_kind_category(TraceKind kind) noexcept {
+            switch (kind) {
+                case TraceKind::WeakCopy:
+                case TraceKind::WeakRelease:
+                    return "weak_ref";
+                case TraceKind::Mark:
+                    return "mark";
+                default:
+                    return "shared_ref";
+            }
+        }
+
+        inline void write_json_string(std::ostream& stream, std::string_view string) {
+            static constexpr char DIGITS[] {"0123456789abcdef"};
+
+            stream << '"';
+
+            for (const char character : string) {
+                const auto byte {static_cast<unsigned char>(character)};
+
+                if (character == '"' || character == '\\') {
+                    stream << '\\' << character;
+                } else if (byte < 0x20) {
+                    stream << "\\u00" << DIGITS[byte >> 4] << DIGITS[byte & 0xF];
+                } else {
+                    stream << character;
+                }
+            }
+
+            stream << '"';
+        }
+
+        inline void write_json_address(std::ostream& stream, const void* address) {
+            static constexpr char DIGITS[] {"0123456789abcdef"};
+
+            char buffer[2 + sizeof(std::uintptr_t) * 2];
+            auto value {reinterpret_cast<std::uintptr_t>(address)};
+
+            for (std::size_t i {sizeof(buffer)}; i > 2; i--) {
+                buffer[i - 1] = DIGITS[value & 0xF];
+                value >>= 4;
+            }
+
+            buffer[0] = '0';
+            buffer[1] = 'x';
+
+            stream << '"';
+            stream.write(buffer, sizeof(buffer));
+            stream << '"';
+        }
+
+        struct TraceThreadEvent {
+            TraceEvent event;
+            std::size_t thread;
+        };
+
+        // Copy the event out of its slot, unless the slot has been overwritten by a newer event in the meantime
+        inline bool read_trace_slot(const TraceSlot& slot, std::uint64_t index, TraceEvent& event) noexcept {
+            if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+                return false;
+            }
+
+            event.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+            event.block = slot.block.load(std::memory_order_relaxed);
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.name_size = slot.name_size.load(std::memory_order_relaxed);
+            event.kind = slot.kind.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+        }
+
+        // Take the events that have not been flushed yet out of every buffer, and forget the buffers of the
+        // threads that have exited
+        // The oldest events may be overwritten while they are being copied, so those are dropped
+        inline std::vector<TraceThreadEvent> take_trace_events(TraceRegistry& registry) {
+            std::vector<TraceThreadEvent> events;
+
+            for (const auto& buffer : registry.buffers) {
+                const std::uint64_t head {buffer->head.load(std::memory_order_acquire)};
+
+                std::uint64_t begin {buffer->flushed};
+
+                if (head - begin > TRACE_BUFFER_SIZE) {
+                    begin = head - TRACE_BUFFER_SIZE;
+                }
+
+                for (std::uint64_t i {begin}; i < head; i++) {
+                    TraceEvent event {};
+
+                    if (read_trace_slot(buffer->slots[i % TRACE_BUFFER_SIZE], i, event)) {
+                        events.push_back(TraceThreadEvent {event, buffer->thread});
+                    }
+                }
+
+                buffer->flushed = head;
+            }
+
+            // A finished buffer is not written to anymore, so it's forgotten once all of its events are taken
+            registry.buffers.erase(
+                std::remove_if(registry.buffers.begin(), registry.buffers.end(), [](const auto& buffer) {
+                    return buffer->finished.load(std::memory_order_acquire) &&
+                        buffer->flushed == buffer->head.load(std::memory_order_relaxed);
+                }),
+                registry.buffers.end()
+            );
+
+            std::stable_sort(events.begin(), events.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.event.timestamp < rhs.event.timestamp;
+            });
+
+            return events;
+        }
+    }
+
+    // Reference count event tracing, compiled in with CPP_SHARED_REF_TRACE
+    // Once started, every creation, copy, release, destruction and lock of shared_refs and weak_refs is recorded,
+    // with its control block, the type of the object and a timestamp, into a lock-free ring buffer of the thread
+    // that made it; each thread keeps its last internal::TRACE_BUFFER_SIZE events
+    // While stopped, each reference count update costs a single branch on a flag that doesn't change
+    namespace trace {
+        // Start recording events
+        inline void start() noexcept {
+            internal::trace_enabled.store(true, std::memory_order_relaxed);
+        }
+
+        // Stop recording events, keeping those already recorded until they are flushed
+        inline void stop() noexcept {
+            internal::trace_enabled.store(false, std::memory_order_relaxed);
+        }
+
+        inline bool started() noexcept {
+            return internal::trace_enabled.load(std::memory_order_relaxed);
+        }
+
+        // Record a global marker, e.g. the start of a frame, to be shown alongside the reference count events
+        // The name must outlive the next flush, so it's best a string literal
+        inline void mark(const char* name) noexcept {
+            internal::trace(internal::TraceKind::Mark, nullptr, std::string_view(name));
+        }
+
+        // Write the events recorded since the last flush to a file, in the Chrome trace event format, which can be
+        // opened with Perfetto or chrome://tracing
+        // Events are instant events on the thread that made them, with the block and the type as arguments
+        // Tracing may go on while flushing
+        inline void flush(const char* path) {
+            internal::TraceRegistry& registry {internal::trace_registry()};
+            std::lock_guard<std::mutex> lock {registry.mutex};
+
+            const std::vector<internal::TraceThreadEvent> events {internal::take_trace_events(registry)};
+
+            std::ofstream stream {path, std::ios::binary};
+
+            if (!stream) {
+                throw bad_trace("Could not open the trace file");
+            }
+
+            stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+            bool first {true};
+            std::unordered_set<const void*> destroyed;
+
+            for (const auto& [event, thread] : events) {
+                stream << (first ? "\n" : ",\n");
+                first = false;
+
+                const std::string_view name {event.name, event.name_size};
+                const std::uint64_t timestamp {event.timestamp};
+
+                stream << "{\"name\":";
+
+                if (event.kind == internal::TraceKind::Mark) {
+                    internal::write_json_string(stream, name);
+                } else {
+                    internal::write_json_string(stream, internal::trace_kind_name(event.kind));
+                }
+
+                stream << ",\"cat\":\"" << internal::trace_kind_category(event.kind) << "\",\"ph\":\"i\"";
+                stream << ",\"s\":\"" << (event.kind == internal::TraceKind::Mark ? 'g' : 't') << '"';
+                stream << ",\"ts\":" << timestamp / 1000 << '.';
+
+                const auto nanoseconds {static_cast<unsigned int>(timestamp % 1000)};
+                stream << nanoseconds / 100 << nanoseconds / 10 % 10 << nanoseconds % 10;
+
+                stream << ",\"pid\":1,\"tid\":" << thread;
+
+                if (event.kind != internal::TraceKind::Mark) {
+                    if (event.kind == internal::TraceKind::Create) {
+                        registry.types[event.block] = name;
+                        destroyed.erase(event.block);
+                    } else if (event.kind == internal::TraceKind::Destroy) {
+                        destroyed.insert(event.block);
+                    }
+
+                    stream << ",\"args\":{\"block\":";
+                    internal::write_json_address(stream, event.block);
+
+                    if (const auto type {registry.types.find(event.block)}; type != registry.types.end()) {
+                        stream << ",\"type\":";
+                        internal::write_json_string(stream, type->second);
+                    }
+
+                    stream << '}';
+                }
+
+                stream << '}';
+            }
+
+            stream << "\n]}\n";
+            stream.flush();
+
+            // The types of destroyed objects are forgotten, so that they don't pile up in long running programs
+            // Their remaining weak events in later flushes are written without a type
+            for (const void* block : destroyed) {
+                registry.types.erase(block);
+            }
+
+            if (!stream) {
+                throw bad_trace("Could not write the trace file");
+            }
+        }
+    }
+}
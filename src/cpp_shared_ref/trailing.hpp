@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>  // std::addressof
+#include <new>
+#include <utility>
+#include <type_traits>
+
+#if __has_include(<version>)
+    #include <version>
+#endif
+
+#ifdef __cpp_lib_span
+    #include <span>
+#endif
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    // View of the elements stored right after an object made by make_shared_trailing
+    template<typename Elem>
+    class trailing_span {
+    public:
+        trailing_span() noexcept = default;
+
+        trailing_span(Elem* data, std::size_t size) noexcept
+            : m_data(data), m_size(size) {}
+
+        Elem* begin() const noexcept {
+            return m_data;
+        }
+
+        Elem* end() const noexcept {
+            return m_data + m_size;
+        }
+
+        Elem* data() const noexcept {
+            return m_data;
+        }
+
+        Elem& operator[](std::size_t index) const noexcept {
+            return m_data[index];
+        }
+
+        std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        bool empty() const noexcept {
+            return m_size == 0;
+        }
+
+#ifdef __cpp_lib_span
+        // Get a view of the elements as a span
+        std::span<Elem> as_span() const noexcept {
+            return std::span<Elem>(m_data, m_size);
+        }
+#endif
+    private:
+        Elem* m_data {nullptr};
+        std::size_t m_size {0};
+    };
+
+    namespace internal {
+        // Control block followed by an object and its trailing elements, in the same allocation
+        template<typename T, typename Elem>
+        class ControlBlockTrailing final : public ControlBlockBase {
+        public:
+            static_assert(
+                alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ && alignof(Elem) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                "Types must not be over-aligned"
+            );
+
+            // The elements are default initialized before the object, so that the object can fill them in
+            template<typename... Args>
+            static ControlBlockTrailing* create(std::size_t count, Args&&... args) {
+                if (count > (~std::size_t(0) - elements_offset()) / sizeof(Elem)) {
+                    throw std::bad_array_new_length();
+                }
+
+                void* memory {::operator new(elements_offset() + sizeof(Elem) * count)};
+                const auto block {::new (memory) ControlBlockTrailing(count)};
+                Elem* const elements {block->elements()};
+
+                std::size_t constructed {0};
+
+                try {
+                    for (; constructed < count; constructed++) {
+                        ::new (static_cast<void*>(elements + constructed)) Elem;
+                    }
+
+                    ::new (static_cast<void*>(std::addressof(block->m_impl.object))) T(
+                        trailing_span<Elem>(elements, count),
+                        std::forward<Args>(args)...
+                    );
+                } catch (...) {
+                    destroy_elements(elements, constructed);
+                    ::operator delete(memory);
+                    throw;
+                }
+
+                return block;
+            }
+
+            // The object first, as it may still use the elements
+            void destroy() const noexcept override {
+                m_impl.object.~T();
+                destroy_elements(std::launder(const_cast<ControlBlockTrailing*>(this)->elements()), m_count);
+            }
+
+            void* get_deleter(TypeId) noexcept override {
+                return nullptr;
+            }
+
+            T* get_ptr() noexcept {
+                return std::addressof(m_impl.object);
+            }
+
+            // Called by the virtual destructor, as the block has been allocated by create
+            static void operator delete(void* ptr) noexcept {
+                ::operator delete(ptr);
+            }
+        private:
+            explicit ControlBlockTrailing(std::size_t count) noexcept
+                : m_count(count) {}
+
+            Elem* elements() noexcept {
+                return reinterpret_cast<Elem*>(reinterpret_cast<unsigned char*>(this) + elements_offset());
+            }
+
+            static constexpr std::size_t elements_offset() noexcept {
+                return (sizeof(ControlBlockTrailing) + alignof(Elem) - 1) / alignof(Elem) * alignof(Elem);
+            }
+
+            static void destroy_elements(Elem* elements, std::size_t count) noexcept {
+                if constexpr (!std::is_trivially_destructible_v<Elem>) {
+                    while (count > 0) {
+                        elements[--count].~Elem();
+                    }
+                }
+            }
+
+            std::size_t m_count {};
+
+            union Impl {
+                Impl() {}
+                ~Impl() {}
+
+                T object;
+            } m_impl;
+        };
+    }
+
+    // Construct a new shared_ref, with count elements stored right after the object, in the same allocation
+    // The object is constructed as T(trailing_span<Elem>, args...), after the elements, which are default
+    // initialized, so trivial ones are left uninitialized for the object to fill in
+    // The elements are destroyed in reverse order after the object
+    template<typename T, typename Elem, typename... Args>
+    shared_ref<T> make_shared_trailing(std::size_t count, Args&&... args) {
+        const auto block {internal::ControlBlockTrailing<T, Elem>::create(count, std::forward<Args>(args)...)};
+
+        shared_ref<T> ref {
+            internal::RefAccess::adopt(block->get_ptr(), internal::ControlBlock(internal::AdoptTag(), block))
+        };
+
+        internal::RefAccess::check_shared_from_this(ref);
+
+        return ref;
+    }
+}
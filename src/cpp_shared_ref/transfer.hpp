@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <exception>
+#include <unordered_map>
+
+#include "internal/control_block.hpp"
+#include "internal/graph.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    // Object thrown by the constructor of transfer_ref, when the object is still referenced by someone else
+    struct bad_transfer_ref : public std::exception {
+        bad_transfer_ref() noexcept = default;
+        bad_transfer_ref(const bad_transfer_ref&) noexcept = default;
+
+        const char* what() const noexcept override {
+            return "Ownership transfer failed, as the object is still shared or observed";
+        }
+    };
+
+    namespace internal {
+        // Check that every object reachable from the root is referenced only from within the graph
+        // The root itself is allowed the one reference that is being transferred
+        template<typename T>
+        bool owns_graph_exclusively(const shared_ref<T>& root) {
+            struct Counts {
+                ControlBlock block;
+                std::size_t strong {0};
+                std::size_t weak {0};
+                bool visited {false};
+            };
+
+            std::unordered_map<const void*, Counts> blocks;
+
+            auto on_ref {[&blocks](const ControlBlock& block, bool strong) {
+                Counts& counts {blocks[block.base()]};
+                counts.block = block;
+
+                if (!strong) {
+                    counts.weak++;
+                    return false;
+                }
+
+                counts.strong++;
+
+                if (counts.visited) {
+                    return false;
+                }
+
+                counts.visited = true;
+                return true;
+            }};
+
+            GraphWalker walker {on_ref};
+            walker(root);
+
+            for (const auto& [base, counts] : blocks) {
+                const std::size_t strong_count {counts.block.strong_count()};
+                const std::size_t weak_count {counts.block.weak_count() - (strong_count > 0 ? 1 : 0)};
+
+                if (strong_count != counts.strong || weak_count != counts.weak) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    // Move-only owner of an object that is about to be handed over to another thread
+    // It can only be made from a shared_ref that is the sole owner of the object and that has no weak_refs, so after
+    // the handoff no other thread can touch the reference counts; the receiving thread gets back a shared_ref
+    // Traceable objects may be observed by weak_refs from within their own graph, e.g. back pointers to a parent,
+    // which is then checked by walking the graph; in debug builds that walk always happens, so that every object
+    // reachable from the transferred one is verified to be referenced only from within the graph
+    template<typename T>
+    class transfer_ref {
+    public:
+        // Construct an empty transfer_ref
+        transfer_ref() noexcept = default;
+
+        // Take the ownership of the object from the shared_ref
+        // Throw an exception, if the object is shared or observed, leaving the shared_ref untouched
+        explicit transfer_ref(shared_ref<T>&& ref) {
+            const internal::ControlBlock& block {internal::RefAccess::block(ref)};
+
+            // Immortal objects are never counted, so they can be handed over as they are
+            if (block && !block.immortal()) {
+                if (block.strong_count() != 1) {
+                    throw bad_transfer_ref();
+                }
+
+                if constexpr (internal::is_traceable_v<T>) {
+                    // Weak references to the root are fine, as long as they come from within the graph itself
+#ifdef NDEBUG
+                    const bool deep_check {block.weak_count() != 1};
+#else
+                    const bool deep_check {true};
+#endif
+
+                    if (deep_check && !internal::owns_graph_exclusively(ref)) {
+                        throw bad_transfer_ref();
+                    }
+                } else {
+                    if (block.weak_count() != 1) {
+                        throw bad_transfer_ref();
+                    }
+                }
+            }
+
+            m_ref = std::move(ref);
+        }
+
+        // Destroy the object, if it hasn't been received
+        ~transfer_ref() noexcept = default;
+
+        transfer_ref(const transfer_ref&) = delete;
+        transfer_ref& operator=(const transfer_ref&) = delete;
+
+        transfer_ref(transfer_ref&& other) noexcept = default;
+        transfer_ref& operator=(transfer_ref&& other) noexcept = default;
+
+        // Get the ownership back as a shared_ref, on the receiving thread
+        // This transfer_ref becomes empty
+        shared_ref<T> receive() noexcept {
+            return std::move(m_ref);
+        }
+
+        // Check if this transfer_ref holds an object
+        explicit operator bool() const noexcept {
+            return static_cast<bool>(m_ref);
+        }
+    private:
+        shared_ref<T> m_ref;
+    };
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>  // std::basic_ostream
+#include <functional>  // std::hash
+#include <utility>
+#include <type_traits>
+
+#include "internal/control_block.hpp"
+#include "memory.hpp"
+
+namespace sm {
+    template<typename T>
+    class unique_ref;
+
+    template<typename T, typename... Args>
+    unique_ref<T> make_unique_ref(Args&&... args);
+
+    // Smart pointer with unique ownership, whose object is allocated together with an unused control block, the
+    // same way as with make_shared
+    // Converting it to a shared_ref takes over the block as it is, without allocating, so objects can be built
+    // through a unique reference and then published as shared at no cost
+    // Objects deriving from enable_shared_from_this can only share themselves after the conversion
+    template<typename T>
+    class unique_ref {
+    public:
+        // Construct an empty unique_ref
+        constexpr unique_ref() noexcept = default;
+
+        // Construct an empty unique_ref
+        constexpr unique_ref(std::nullptr_t) noexcept {}
+
+        // Destroy the object and free the block, if not empty
+        ~unique_ref() noexcept {
+            destroy_this();
+        }
+
+        unique_ref(const unique_ref&) = delete;
+        unique_ref& operator=(const unique_ref&) = delete;
+
+        unique_ref(unique_ref&& other) noexcept
+            : m_ptr(std::exchange(other.m_ptr, nullptr)), m_block(std::exchange(other.m_block, {})) {}
+
+        // The object is destroyed through its block, so a base doesn't need a virtual destructor
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        unique_ref(unique_ref<U>&& other) noexcept
+            : m_ptr(std::exchange(other.m_ptr, nullptr)), m_block(std::exchange(other.m_block, {})) {}
+
+        unique_ref& operator=(unique_ref&& other) noexcept {
+            unique_ref(std::move(other)).swap(*this);
+
+            return *this;
+        }
+
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        unique_ref& operator=(unique_ref<U>&& other) noexcept {
+            unique_ref(std::move(other)).swap(*this);
+
+            return *this;
+        }
+
+        unique_ref& operator=(std::nullptr_t) noexcept {
+            reset();
+
+            return *this;
+        }
+
+        // Give the object to a shared_ref, leaving this unique_ref empty
+        // The block already has the counts of a single shared_ref, so this doesn't allocate or update any count
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<T*, U*>>>
+        operator shared_ref<U>() && noexcept {
+            shared_ref<T> ref {internal::RefAccess::adopt(m_ptr, m_block)};
+
+            m_ptr = nullptr;
+            m_block = {};
+
+            internal::RefAccess::check_shared_from_this(ref);
+
+            return shared_ref<U>(std::move(ref));
+        }
+
+        T* get() const noexcept {
+            return m_ptr;
+        }
+
+        T& operator*() const noexcept {
+            return *m_ptr;
+        }
+
+        T* operator->() const noexcept {
+            return m_ptr;
+        }
+
+        // Check if the stored pointer is not null
+        explicit operator bool() const noexcept {
+            return m_ptr != nullptr;
+        }
+
+        // Destroy the object and free the block, leaving this unique_ref empty
+        void reset() noexcept {
+            destroy_this();
+
+            m_ptr = nullptr;
+            m_block = {};
+        }
+
+        void swap(unique_ref& other) noexcept {
+            std::swap(m_ptr, other.m_ptr);
+            std::swap(m_block, other.m_block);
+        }
+    private:
+        unique_ref(T* ptr, internal::ControlBlock block) noexcept
+            : m_ptr(ptr), m_block(block) {}
+
+        void destroy_this() noexcept {
+            if (m_block) {
+                m_block.release_strong();
+            }
+        }
+
+        T* m_ptr {nullptr};
+        internal::ControlBlock m_block;
+
+        template<typename U>
+        friend class unique_ref;
+
+        template<typename U, typename... Args>
+        friend unique_ref<U> make_unique_ref(Args&&... args);
+    };
+
+    // Construct a new unique_ref, with the object and its control block in a single allocation
+    template<typename T, typename... Args>
+    unique_ref<T> make_unique_ref(Args&&... args) {
+        T* ptr {nullptr};
+        internal::ControlBlock block {ptr, internal::MakeSharedTag(), std::forward<Args>(args)...};
+
+        return unique_ref<T>(ptr, block);
+    }
+}
+
+// Comparison operators with another unique_ref or with nullptr
+
+template<typename T, typename U>
+bool operator==(const sm::unique_ref<T>& lhs, const sm::unique_ref<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U>
+bool operator!=(const sm::unique_ref<T>& lhs, const sm::unique_ref<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template<typename T>
+bool operator==(const sm::unique_ref<T>& lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+
+template<typename T>
+bool operator==(std::nullptr_t, const sm::unique_ref<T>& rhs) noexcept {
+    return !rhs;
+}
+
+template<typename T>
+bool operator!=(const sm::unique_ref<T>& lhs, std::nullptr_t) noexcept {
+    return static_cast<bool>(lhs);
+}
+
+template<typename T>
+bool operator!=(std::nullptr_t, const sm::unique_ref<T>& rhs) noexcept {
+    return static_cast<bool>(rhs);
+}
+
+// Write the stored pointer of the unique_ref object to the output stream
+template<typename CharType, typename Traits, typename T>
+std::basic_ostream<CharType, Traits>& operator<<(std::basic_ostream<CharType, Traits>& stream, const sm::unique_ref<T>& ref) {
+    stream << ref.get();
+
+    return stream;
+}
+
+namespace std {
+    // Swap two unique_ref objects
+    template<typename T>
+    void swap(sm::unique_ref<T>& lhs, sm::unique_ref<T>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // Get the hash of the unique_ref object, i.e. the hash of the stored pointer
+    template<typename T>
+    struct hash<sm::unique_ref<T>> {
+        size_t operator()(const sm::unique_ref<T>& ref) const noexcept {
+            return hash<T*>()(ref.get());
+        }
+    };
+}
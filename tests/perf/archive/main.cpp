@@ -0,0 +1,114 @@
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+
+#include <cpp_shared_ref/archive.hpp>
+
+enum class Type {
+    Write,
+    Read
+};
+
+struct Node {
+    template<typename Archive>
+    void serialize(Archive& archive) {
+        archive(id, payload, children);
+    }
+
+    unsigned int id {};
+    std::vector<int> payload;
+    std::vector<sm::shared_ref<Node>> children;
+};
+
+// Layers of nodes, each one referring to a few nodes of the layer below, so that most nodes are shared
+static std::vector<sm::shared_ref<Node>> make_dag(std::size_t layers, std::size_t width) {
+    std::vector<sm::shared_ref<Node>> below;
+    unsigned int id {0};
+
+    for (std::size_t layer {0}; layer < layers; layer++) {
+        std::vector<sm::shared_ref<Node>> current;
+
+        for (std::size_t i {0}; i < width; i++) {
+            sm::shared_ref<Node> node {sm::make_shared<Node>()};
+            node->id = id++;
+            node->payload.assign(8, static_cast<int>(i));
+
+            if (!below.empty()) {
+                for (std::size_t j {0}; j < 3; j++) {
+                    node->children.push_back(below[(i * 7919 + j * 104729) % below.size()]);
+                }
+            }
+
+            current.push_back(std::move(node));
+        }
+
+        below = std::move(current);
+    }
+
+    return below;
+}
+
+template<typename F>
+static double measure(F function) {
+    const auto begin {std::chrono::high_resolution_clock::now()};
+
+    function();
+
+    const auto end {std::chrono::high_resolution_clock::now()};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()) / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "write") == 0) {
+        type = Type::Write;
+    } else if (std::strcmp(arg, "read") == 0) {
+        type = Type::Read;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    static constexpr std::size_t LAYERS {20};
+    static constexpr std::size_t WIDTH {50'000};
+
+    std::vector<sm::shared_ref<Node>> roots {make_dag(LAYERS, WIDTH)};
+    std::stringstream stream;
+
+    const double write {measure([&] {
+        sm::archive_writer writer {stream};
+        writer(roots);
+        writer.finish();
+    })};
+
+    const double size {static_cast<double>(stream.str().size()) / (1024.0 * 1024.0)};
+
+    switch (type) {
+        case Type::Write:
+            std::cout << "Writing " << size << " MiB took " << write << " ms (" << size / write * 1000.0 << " MiB/s)\n";
+            break;
+        case Type::Read: {
+            roots.clear();
+
+            const double read {measure([&] {
+                sm::archive_reader reader {stream};
+                reader(roots);
+            })};
+
+            std::cout << "Reading " << size << " MiB took " << read << " ms (" << size / read * 1000.0 << " MiB/s)\n";
+            break;
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <functional>
+
+#include <cpp_shared_ref/function.hpp>
+
+enum class Type {
+    Std,
+    Shared
+};
+
+// Push copies of callbacks through a task queue, as if posting them to several listeners, then run them
+template<typename Function>
+static std::size_t run_queue(std::size_t count, std::size_t copies) {
+    std::vector<Function> callbacks;
+
+    for (std::size_t i {0}; i < count; i++) {
+        callbacks.push_back([name = std::string(32, 'a') + std::to_string(i), i](std::size_t value) {
+            return name.size() + i + value;
+        });
+    }
+
+    std::deque<Function> queue;
+    std::size_t result {0};
+
+    for (std::size_t copy {0}; copy < copies; copy++) {
+        for (const Function& callback : callbacks) {
+            queue.push_back(callback);
+        }
+
+        while (!queue.empty()) {
+            result += queue.front()(copy);
+            queue.pop_front();
+        }
+    }
+
+    return result;
+}
+
+template<typename F>
+static double measure(F function) {
+    const auto begin {std::chrono::high_resolution_clock::now()};
+
+    function();
+
+    const auto end {std::chrono::high_resolution_clock::now()};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()) / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "std") == 0) {
+        type = Type::Std;
+    } else if (std::strcmp(arg, "shared") == 0) {
+        type = Type::Shared;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    static constexpr std::size_t COUNT {100'000};
+    static constexpr std::size_t COPIES {20};
+
+    double time {};
+    std::size_t result {};
+
+    switch (type) {
+        case Type::Std:
+            time = measure([&] {
+                result = run_queue<std::function<std::size_t(std::size_t)>>(COUNT, COPIES);
+            });
+            break;
+        case Type::Shared:
+            time = measure([&] {
+                result = run_queue<sm::shared_function<std::size_t(std::size_t)>>(COUNT, COPIES);
+            });
+            break;
+    }
+
+    std::cout << "Queueing " << COUNT * COPIES << " callbacks took " << time << " ms (" << result << ")\n";
+}
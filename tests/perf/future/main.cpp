@@ -0,0 +1,113 @@
+#include <chrono>
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include <future>
+
+#include <cpp_shared_ref/future.hpp>
+
+enum class Type {
+    Std,
+    Local
+};
+
+static long long sink {0};
+
+// Make a promise, hand out its future, fulfill it and read the result, like an event loop does for every request
+static void round_trips_std(std::size_t count) {
+    for (std::size_t i {0}; i < count; i++) {
+        std::promise<int> promise;
+        std::shared_future<int> future {promise.get_future().share()};
+        promise.set_value(static_cast<int>(i));
+        sink += future.get();
+    }
+}
+
+static void round_trips_local(std::size_t count) {
+    for (std::size_t i {0}; i < count; i++) {
+        sm::local_promise<int> promise;
+        sm::local_future<int> future {promise.get_future()};
+        promise.set_value(static_cast<int>(i));
+        sink += future.get();
+    }
+}
+
+// Same as above, but the future is copied to a number of waiting parties
+static void fan_out_std(std::size_t count, std::size_t copies) {
+    for (std::size_t i {0}; i < count; i++) {
+        std::promise<int> promise;
+        std::shared_future<int> future {promise.get_future().share()};
+        std::vector<std::shared_future<int>> waiting(copies, future);
+        promise.set_value(static_cast<int>(i));
+
+        for (const std::shared_future<int>& copy : waiting) {
+            sink += copy.get();
+        }
+    }
+}
+
+static void fan_out_local(std::size_t count, std::size_t copies) {
+    for (std::size_t i {0}; i < count; i++) {
+        sm::local_promise<int> promise;
+        sm::local_future<int> future {promise.get_future()};
+        std::vector<sm::local_future<int>> waiting(copies, future);
+        promise.set_value(static_cast<int>(i));
+
+        for (const sm::local_future<int>& copy : waiting) {
+            sink += copy.get();
+        }
+    }
+}
+
+template<typename F>
+static double measure(F function) {
+    const auto begin {std::chrono::high_resolution_clock::now()};
+
+    function();
+
+    const auto end {std::chrono::high_resolution_clock::now()};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()) / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "std") == 0) {
+        type = Type::Std;
+    } else if (std::strcmp(arg, "local") == 0) {
+        type = Type::Local;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    static constexpr std::size_t ROUND_TRIPS {1'000'000};
+    static constexpr std::size_t FAN_OUTS {100'000};
+    static constexpr std::size_t COPIES {16};
+
+    double round_trips {};
+    double fan_out {};
+
+    switch (type) {
+        case Type::Std:
+            round_trips = measure([] { round_trips_std(ROUND_TRIPS); });
+            fan_out = measure([] { fan_out_std(FAN_OUTS, COPIES); });
+            break;
+        case Type::Local:
+            round_trips = measure([] { round_trips_local(ROUND_TRIPS); });
+            fan_out = measure([] { fan_out_local(FAN_OUTS, COPIES); });
+            break;
+    }
+
+    std::cout << ROUND_TRIPS << " round trips took " << round_trips << " ms\n";
+    std::cout << FAN_OUTS << " fan-outs to " << COPIES << " copies took " << fan_out << " ms\n";
+    std::cout << "(checksum " << sink << ")\n";
+}
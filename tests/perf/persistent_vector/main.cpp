@@ -0,0 +1,115 @@
+#include <chrono>
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+
+#include <cpp_shared_ref/persistent_vector.hpp>
+
+enum class Type {
+    Vector,
+    Persistent
+};
+
+// Keep every version after appending one element, like an undo history
+static void history_vector(std::size_t count) {
+    std::vector<std::vector<int>> versions {std::vector<int>()};
+
+    for (std::size_t i {0}; i < count; i++) {
+        std::vector<int> version {versions.back()};
+        version.push_back(static_cast<int>(i));
+        versions.push_back(std::move(version));
+    }
+}
+
+static void history_persistent(std::size_t count) {
+    std::vector<sm::persistent_vector<int>> versions {sm::persistent_vector<int>()};
+
+    for (std::size_t i {0}; i < count; i++) {
+        versions.push_back(versions.back().push_back(static_cast<int>(i)));
+    }
+}
+
+// Keep a snapshot of a large state every frame, in which a few elements change
+static void snapshots_vector(std::size_t size, std::size_t frames) {
+    std::vector<int> state(size);
+    std::vector<std::vector<int>> snapshots;
+
+    for (std::size_t frame {0}; frame < frames; frame++) {
+        for (std::size_t i {0}; i < 16; i++) {
+            state[(frame * 7919 + i * 104729) % size] = static_cast<int>(frame);
+        }
+
+        snapshots.push_back(state);
+    }
+}
+
+static void snapshots_persistent(std::size_t size, std::size_t frames) {
+    sm::transient_vector<int> builder;
+
+    for (std::size_t i {0}; i < size; i++) {
+        builder.push_back(0);
+    }
+
+    sm::transient_vector<int> state {builder.persistent().transient()};
+    std::vector<sm::persistent_vector<int>> snapshots;
+
+    for (std::size_t frame {0}; frame < frames; frame++) {
+        for (std::size_t i {0}; i < 16; i++) {
+            state.set((frame * 7919 + i * 104729) % size, static_cast<int>(frame));
+        }
+
+        snapshots.push_back(state.persistent());
+    }
+}
+
+template<typename F>
+static double measure(F function) {
+    const auto begin {std::chrono::high_resolution_clock::now()};
+
+    function();
+
+    const auto end {std::chrono::high_resolution_clock::now()};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()) / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "vector") == 0) {
+        type = Type::Vector;
+    } else if (std::strcmp(arg, "persistent") == 0) {
+        type = Type::Persistent;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    static constexpr std::size_t HISTORY {20'000};
+    static constexpr std::size_t SIZE {100'000};
+    static constexpr std::size_t FRAMES {1000};
+
+    double history {};
+    double snapshots {};
+
+    switch (type) {
+        case Type::Vector:
+            history = measure([] { history_vector(HISTORY); });
+            snapshots = measure([] { snapshots_vector(SIZE, FRAMES); });
+            break;
+        case Type::Persistent:
+            history = measure([] { history_persistent(HISTORY); });
+            snapshots = measure([] { snapshots_persistent(SIZE, FRAMES); });
+            break;
+    }
+
+    std::cout << "History of " << HISTORY << " push_backs took " << history << " ms\n";
+    std::cout << FRAMES << " snapshots of " << SIZE << " elements took " << snapshots << " ms\n";
+}
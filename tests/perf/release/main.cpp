@@ -0,0 +1,88 @@
+#include <chrono>
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <cpp_shared_ref/release.hpp>
+
+enum class Type {
+    Clear,
+    ReleaseAll
+};
+
+struct Payload {
+    Payload() = default;
+
+    ~Payload() {
+        checksum += values[0];
+    }
+
+    int values[8] {1};
+
+    static inline long long checksum {0};
+};
+
+// References in a random order, like a container filled over time from all over the program
+static std::vector<sm::shared_ref<Payload>> make_refs(std::size_t count) {
+    std::vector<sm::shared_ref<Payload>> refs;
+
+    for (std::size_t i {0}; i < count; i++) {
+        refs.push_back(sm::make_shared<Payload>());
+    }
+
+    std::shuffle(refs.begin(), refs.end(), std::mt19937(21));
+
+    return refs;
+}
+
+template<typename F>
+static double measure(F function) {
+    const auto begin {std::chrono::high_resolution_clock::now()};
+
+    function();
+
+    const auto end {std::chrono::high_resolution_clock::now()};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()) / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "clear") == 0) {
+        type = Type::Clear;
+    } else if (std::strcmp(arg, "release_all") == 0) {
+        type = Type::ReleaseAll;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    static constexpr std::size_t COUNT {1'000'000};
+
+    std::vector<sm::shared_ref<Payload>> refs {make_refs(COUNT)};
+    double release {};
+
+    switch (type) {
+        case Type::Clear:
+            release = measure([&] { refs.clear(); });
+            break;
+        case Type::ReleaseAll:
+            release = measure([&] {
+                sm::release_all(refs.begin(), refs.end());
+                refs.clear();
+            });
+            break;
+    }
+
+    std::cout << "Releasing " << COUNT << " shuffled references took " << release << " ms (" << Payload::checksum << ")\n";
+}
@@ -0,0 +1,121 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include <unordered_set>
+#include <functional>
+
+#include <cpp_shared_ref/memory.hpp>
+#include <cpp_shared_ref/shared_string.hpp>
+
+enum class Type {
+    Ref,
+    String
+};
+
+// Keys of various lengths, some short enough to be stored inline
+static std::vector<std::string> make_keys(std::size_t count) {
+    std::vector<std::string> keys;
+
+    for (std::size_t i {0}; i < count; i++) {
+        keys.push_back(std::string("key:") + std::string(i % 48, 'k') + std::to_string(i));
+    }
+
+    return keys;
+}
+
+struct RefHash {
+    std::size_t operator()(const sm::shared_ref<std::string>& string) const noexcept {
+        return std::hash<std::string>()(*string);
+    }
+};
+
+struct RefEqual {
+    bool operator()(const sm::shared_ref<std::string>& lhs, const sm::shared_ref<std::string>& rhs) const noexcept {
+        return *lhs == *rhs;
+    }
+};
+
+// Create the strings, pass copies of them around and look them up in a set, over and over
+template<typename String, typename Hash, typename Equal, typename Make>
+static std::size_t churn(const std::vector<std::string>& keys, std::size_t rounds, Make make) {
+    std::vector<String> strings;
+
+    for (const std::string& key : keys) {
+        strings.push_back(make(key));
+    }
+
+    std::unordered_set<String, Hash, Equal> set {strings.begin(), strings.end()};
+    std::size_t found {0};
+
+    for (std::size_t round {0}; round < rounds; round++) {
+        std::vector<String> copies {strings};
+
+        for (const String& string : copies) {
+            found += set.count(string);
+        }
+    }
+
+    return found;
+}
+
+template<typename F>
+static double measure(F function) {
+    const auto begin {std::chrono::high_resolution_clock::now()};
+
+    function();
+
+    const auto end {std::chrono::high_resolution_clock::now()};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()) / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "ref") == 0) {
+        type = Type::Ref;
+    } else if (std::strcmp(arg, "string") == 0) {
+        type = Type::String;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    static constexpr std::size_t COUNT {500'000};
+    static constexpr std::size_t ROUNDS {5};
+
+    const std::vector<std::string> keys {make_keys(COUNT)};
+    double time {};
+    std::size_t found {};
+
+    switch (type) {
+        case Type::Ref:
+            time = measure([&] {
+                found = churn<sm::shared_ref<std::string>, RefHash, RefEqual>(keys, ROUNDS, [](const std::string& key) {
+                    return sm::make_shared<std::string>(key);
+                });
+            });
+            break;
+        case Type::String:
+            time = measure([&] {
+                found = churn<sm::shared_string, std::hash<sm::shared_string>, std::equal_to<sm::shared_string>>(
+                    keys,
+                    ROUNDS,
+                    [](const std::string& key) { return sm::shared_string(key); }
+                );
+            });
+            break;
+    }
+
+    std::cout << "Churning " << COUNT << " strings took " << time << " ms (" << found << ")\n";
+}
@@ -0,0 +1,168 @@
+#include <chrono>
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+#include <cpp_shared_ref/signal.hpp>
+
+enum class Type {
+    Weak,
+    Signal,
+    Unguarded
+};
+
+struct Observer {
+    void on_event(int value) {
+        sum += value;
+    }
+
+    long long sum {0};
+};
+
+// One signal with a number of observers, a quarter of which are destroyed halfway through
+static std::vector<sm::shared_ref<Observer>> make_observers(std::size_t count) {
+    std::vector<sm::shared_ref<Observer>> observers;
+
+    for (std::size_t i {0}; i < count; i++) {
+        observers.push_back(sm::make_shared<Observer>());
+    }
+
+    return observers;
+}
+
+static long long total(const std::vector<sm::shared_ref<Observer>>& observers) {
+    long long result {0};
+
+    for (const sm::shared_ref<Observer>& observer : observers) {
+        result += observer ? observer->sum : 0;
+    }
+
+    return result;
+}
+
+static void kill_some(std::vector<sm::shared_ref<Observer>>& observers) {
+    for (std::size_t i {0}; i < observers.size(); i += 4) {
+        observers[i].reset();
+    }
+}
+
+static long long dispatch_weak(std::size_t observers_count, std::size_t events) {
+    std::vector<sm::shared_ref<Observer>> observers {make_observers(observers_count)};
+
+    // The usual observer list, with callbacks stored alongside weak_refs
+    struct Entry {
+        sm::weak_ref<Observer> observer;
+        std::function<void(Observer&, int)> callback;
+    };
+
+    std::vector<Entry> list;
+
+    for (const sm::shared_ref<Observer>& observer : observers) {
+        list.push_back({observer, &Observer::on_event});
+    }
+
+    for (std::size_t event {0}; event < events; event++) {
+        if (event == events / 2) {
+            kill_some(observers);
+        }
+
+        for (const Entry& entry : list) {
+            if (sm::shared_ref<Observer> observer {entry.observer.lock()}) {
+                entry.callback(*observer, static_cast<int>(event));
+            }
+        }
+
+        // Separate cleanup pass
+        if (event % 64 == 0) {
+            std::vector<Entry> alive;
+
+            for (const Entry& entry : list) {
+                if (!entry.observer.expired()) {
+                    alive.push_back(entry);
+                }
+            }
+
+            list = std::move(alive);
+        }
+    }
+
+    return total(observers);
+}
+
+template<bool Unguarded>
+static long long dispatch_signal(std::size_t observers_count, std::size_t events) {
+    std::vector<sm::shared_ref<Observer>> observers {make_observers(observers_count)};
+    sm::signal<int> signal;
+
+    for (const sm::shared_ref<Observer>& observer : observers) {
+        signal.connect(observer, &Observer::on_event);
+    }
+
+    for (std::size_t event {0}; event < events; event++) {
+        if (event == events / 2) {
+            kill_some(observers);
+        }
+
+        if constexpr (Unguarded) {
+            signal.emit_unguarded(static_cast<int>(event));
+        } else {
+            signal.emit(static_cast<int>(event));
+        }
+    }
+
+    return total(observers);
+}
+
+template<typename F>
+static double measure(F function) {
+    const auto begin {std::chrono::high_resolution_clock::now()};
+
+    function();
+
+    const auto end {std::chrono::high_resolution_clock::now()};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()) / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "weak") == 0) {
+        type = Type::Weak;
+    } else if (std::strcmp(arg, "signal") == 0) {
+        type = Type::Signal;
+    } else if (std::strcmp(arg, "unguarded") == 0) {
+        type = Type::Unguarded;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    static constexpr std::size_t OBSERVERS {64};
+    static constexpr std::size_t EVENTS {1'000'000};
+
+    double dispatch {};
+    long long result {};
+
+    switch (type) {
+        case Type::Weak:
+            dispatch = measure([&] { result = dispatch_weak(OBSERVERS, EVENTS); });
+            break;
+        case Type::Signal:
+            dispatch = measure([&] { result = dispatch_signal<false>(OBSERVERS, EVENTS); });
+            break;
+        case Type::Unguarded:
+            dispatch = measure([&] { result = dispatch_signal<true>(OBSERVERS, EVENTS); });
+            break;
+    }
+
+    std::cout << EVENTS << " events to " << OBSERVERS << " observers took " << dispatch << " ms (" << result << ")\n";
+}
@@ -0,0 +1,175 @@
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#include <cpp_shared_ref/archive.hpp>
+#include <cpp_shared_ref/snapshot.hpp>
+
+enum class Type {
+    Archive,
+    Snapshot
+};
+
+static constexpr std::size_t LAYERS {20};
+static constexpr std::size_t WIDTH {50'000};
+
+static std::size_t child_index(std::size_t i, std::size_t j) {
+    return (i * 7919 + j * 104729) % WIDTH;
+}
+
+struct ArchiveNode {
+    template<typename Archive>
+    void serialize(Archive& archive) {
+        archive(value, children);
+    }
+
+    int value {};
+    std::vector<sm::shared_ref<ArchiveNode>> children;
+};
+
+struct SnapshotNode {
+    int value {};
+    sm::snapshot_span<SnapshotNode> children;
+};
+
+struct SnapshotLayer {
+    sm::snapshot_span<SnapshotNode> nodes;
+};
+
+// The same graph in both formats: layers of nodes, each one referring to a few nodes of the layer below
+static void write_archive(const char* path) {
+    std::vector<sm::shared_ref<ArchiveNode>> below;
+
+    for (std::size_t layer {0}; layer < LAYERS; layer++) {
+        std::vector<sm::shared_ref<ArchiveNode>> current;
+
+        for (std::size_t i {0}; i < WIDTH; i++) {
+            sm::shared_ref<ArchiveNode> node {sm::make_shared<ArchiveNode>()};
+            node->value = static_cast<int>(i);
+
+            if (!below.empty()) {
+                for (std::size_t j {0}; j < 3; j++) {
+                    node->children.push_back(below[child_index(i, j)]);
+                }
+            }
+
+            current.push_back(std::move(node));
+        }
+
+        below = std::move(current);
+    }
+
+    std::ofstream stream {path, std::ios::binary};
+    sm::archive_writer writer {stream};
+    writer(below);
+    writer.finish();
+}
+
+// Children are not shared in place, but stored as copies of spans of the layer below
+static void write_snapshot(const char* path) {
+    sm::snapshot_builder builder;
+    sm::snapshot_offset<SnapshotNode> below {};
+
+    for (std::size_t layer {0}; layer < LAYERS; layer++) {
+        const auto current {builder.emplace_array<SnapshotNode>(WIDTH)};
+
+        for (std::size_t i {0}; i < WIDTH; i++) {
+            SnapshotNode& node {(&builder[current])[i]};
+            node.value = static_cast<int>(i);
+
+            if (layer > 0) {
+                node.children.assign(&builder[below] + child_index(i, 0), 1);
+            }
+        }
+
+        below = current;
+    }
+
+    const auto root {builder.emplace<SnapshotLayer>()};
+    builder[root].nodes.assign(&builder[below], WIDTH);
+
+    std::ofstream stream {path, std::ios::binary};
+    builder.write(stream, root);
+}
+
+static long long load_archive(const char* path) {
+    std::ifstream stream {path, std::ios::binary};
+    sm::archive_reader reader {stream};
+
+    std::vector<sm::shared_ref<ArchiveNode>> roots;
+    reader(roots);
+
+    long long result {0};
+
+    for (const auto& root : roots) {
+        result += root->value + root->children[0]->value;
+    }
+
+    return result;
+}
+
+static long long load_snapshot(const char* path) {
+    sm::shared_ref<const SnapshotLayer> roots {sm::map_snapshot<SnapshotLayer>(path)};
+
+    long long result {0};
+
+    for (const SnapshotNode& root : roots->nodes) {
+        result += root.value + root.children[0].value;
+    }
+
+    return result;
+}
+
+template<typename F>
+static double measure(F function) {
+    const auto begin {std::chrono::high_resolution_clock::now()};
+
+    function();
+
+    const auto end {std::chrono::high_resolution_clock::now()};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()) / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "archive") == 0) {
+        type = Type::Archive;
+    } else if (std::strcmp(arg, "snapshot") == 0) {
+        type = Type::Snapshot;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    const char* path {"test_snapshot.bin"};
+    double load {};
+    long long result {};
+
+    switch (type) {
+        case Type::Archive:
+            write_archive(path);
+            load = measure([&] { result = load_archive(path); });
+            break;
+        case Type::Snapshot:
+            write_snapshot(path);
+            load = measure([&] { result = load_snapshot(path); });
+            break;
+    }
+
+    std::remove(path);
+
+    std::cout << "Loading " << LAYERS * WIDTH << " nodes took " << load << " ms (" << result << ")\n";
+}
@@ -0,0 +1,669 @@
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <random>
+#include <algorithm>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+#include <cpp_shared_ref/memory.hpp>
+
+// Every allocation of the program is counted, including those of the standard containers, which are the same
+// for both kinds of pointers
+// The replacements are not inlined, as GCC would then see new paired with free and warn about it
+#if defined(__GNUC__) || defined(__clang__)
+    #define NOINLINE __attribute__((noinline))
+#else
+    #define NOINLINE
+#endif
+
+static std::size_t g_allocations {0};
+static std::size_t g_deallocations {0};
+static std::size_t g_allocated_bytes {0};
+
+NOINLINE void* operator new(std::size_t size) {
+    g_allocations++;
+    g_allocated_bytes += size;
+
+    if (void* ptr {std::malloc(size == 0 ? 1 : size)}) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+NOINLINE void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr) {
+        g_deallocations++;
+    }
+
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+enum class Type {
+    Ref,
+    Ptr
+};
+
+enum class Workload {
+    Scene,
+    Ast,
+    Cache,
+    Bus
+};
+
+struct RefFamily {
+    template<typename T>
+    using Shared = sm::shared_ref<T>;
+
+    template<typename T>
+    using Weak = sm::weak_ref<T>;
+
+    template<typename T>
+    static Shared<T> make() {
+        return sm::make_shared<T>();
+    }
+};
+
+struct PtrFamily {
+    template<typename T>
+    using Shared = std::shared_ptr<T>;
+
+    template<typename T>
+    using Weak = std::weak_ptr<T>;
+
+    template<typename T>
+    static Shared<T> make() {
+        return std::make_shared<T>();
+    }
+};
+
+// Scene graph, in which nodes own their children and refer to their parents weakly
+// Every frame, the world position of some nodes is computed by locking the parents up to the root, some subtrees
+// are moved to other parents, some are destroyed and new nodes are spawned
+template<typename P>
+class SceneWorkload {
+public:
+    explicit SceneWorkload(std::mt19937& random)
+        : m_random(random) {
+        m_root = P::template make<Node>();
+        m_nodes.push_back(m_root);
+
+        while (m_nodes.size() < NODES) {
+            spawn();
+        }
+    }
+
+    std::size_t round() {
+        std::size_t steps {0};
+
+        for (std::size_t frame {0}; frame < FRAMES; frame++) {
+            for (std::size_t i {0}; i < UPDATES; i++) {
+                steps += update(pick());
+            }
+
+            for (std::size_t i {0}; i < MOVES; i++) {
+                move(pick(), pick());
+            }
+
+            for (std::size_t i {0}; i < REMOVALS; i++) {
+                remove(pick());
+            }
+
+            m_nodes.erase(
+                std::remove_if(m_nodes.begin(), m_nodes.end(), [](const auto& node) { return node.expired(); }),
+                m_nodes.end()
+            );
+
+            while (m_nodes.size() < NODES) {
+                spawn();
+            }
+        }
+
+        return steps;
+    }
+private:
+    struct Node {
+        typename P::template Weak<Node> parent;
+        std::vector<typename P::template Shared<Node>> children;
+        float position[3] {};
+    };
+
+    using Shared = typename P::template Shared<Node>;
+
+    static constexpr std::size_t NODES {50'000};
+    static constexpr std::size_t FRAMES {100};
+    static constexpr std::size_t UPDATES {5'000};
+    static constexpr std::size_t MOVES {200};
+    static constexpr std::size_t REMOVALS {20};
+
+    Shared pick() {
+        return m_nodes[std::uniform_int_distribution<std::size_t>(0, m_nodes.size() - 1)(m_random)].lock();
+    }
+
+    void spawn() {
+        Shared parent {pick()};
+
+        if (!parent) {
+            parent = m_root;
+        }
+
+        Shared node {P::template make<Node>()};
+        node->parent = parent;
+        node->position[0] = static_cast<float>(m_random() % 100);
+        parent->children.push_back(node);
+        m_nodes.push_back(node);
+    }
+
+    std::size_t update(Shared node) {
+        std::size_t steps {0};
+        float world[3] {};
+
+        while (node) {
+            world[0] += node->position[0];
+            world[1] += node->position[1];
+            world[2] += node->position[2];
+            node = node->parent.lock();
+            steps++;
+        }
+
+        m_sink += world[0] + world[1] + world[2];
+
+        return steps;
+    }
+
+    void detach(const Shared& node) {
+        if (const Shared parent {node->parent.lock()}) {
+            auto& children {parent->children};
+            const auto iter {std::find(children.begin(), children.end(), node)};
+            std::swap(*iter, children.back());
+            children.pop_back();
+        }
+    }
+
+    void move(const Shared& node, const Shared& parent) {
+        if (!node || !parent || node == m_root) {
+            return;
+        }
+
+        // The new parent must not be in the subtree of the node
+        for (Shared ancestor {parent}; ancestor; ancestor = ancestor->parent.lock()) {
+            if (ancestor == node) {
+                return;
+            }
+        }
+
+        detach(node);
+        node->parent = parent;
+        parent->children.push_back(node);
+    }
+
+    void remove(const Shared& node) {
+        if (node && node != m_root) {
+            detach(node);
+        }
+    }
+
+    std::mt19937& m_random;
+    Shared m_root;
+    std::vector<typename P::template Weak<Node>> m_nodes;
+    float m_sink {};
+};
+
+// Expression trees of a compiler, in which subtrees are shared by several parents
+// Every round, a layered expression graph is built, then folded into a new graph that shares the unchanged
+// subtrees with the old one, and then evaluated
+template<typename P>
+class AstWorkload {
+public:
+    explicit AstWorkload(std::mt19937& random)
+        : m_random(random) {}
+
+    std::size_t round() {
+        std::vector<std::vector<Shared>> levels {build()};
+
+        std::unordered_map<const Node*, Shared> folded;
+        std::vector<Shared> roots;
+
+        for (const Shared& root : levels.back()) {
+            roots.push_back(fold(root, folded));
+        }
+
+        levels.clear();
+
+        std::unordered_map<const Node*, long> values;
+        long result {0};
+
+        for (const Shared& root : roots) {
+            result += evaluate(root, values);
+        }
+
+        m_sink += result;
+
+        return folded.size() + values.size();
+    }
+private:
+    struct Node {
+        enum class Kind {
+            Number,
+            Variable,
+            Add,
+            Mul
+        } kind {};
+
+        long value {};
+        typename P::template Shared<Node> lhs;
+        typename P::template Shared<Node> rhs;
+    };
+
+    using Shared = typename P::template Shared<Node>;
+
+    static constexpr std::size_t LEVELS {24};
+    static constexpr std::size_t WIDTH {4'000};
+
+    std::vector<std::vector<Shared>> build() {
+        std::vector<std::vector<Shared>> levels;
+
+        levels.emplace_back();
+
+        for (std::size_t i {0}; i < WIDTH; i++) {
+            Shared leaf {P::template make<Node>()};
+            leaf->kind = m_random() % 4 == 0 ? Node::Kind::Variable : Node::Kind::Number;
+            leaf->value = static_cast<long>(m_random() % 8);
+            levels.back().push_back(std::move(leaf));
+        }
+
+        for (std::size_t level {1}; level < LEVELS; level++) {
+            std::vector<Shared> nodes;
+
+            for (std::size_t i {0}; i < WIDTH; i++) {
+                Shared node {P::template make<Node>()};
+                node->kind = m_random() % 2 == 0 ? Node::Kind::Add : Node::Kind::Mul;
+                node->lhs = child(levels, level);
+                node->rhs = child(levels, level);
+                nodes.push_back(std::move(node));
+            }
+
+            levels.push_back(std::move(nodes));
+        }
+
+        return levels;
+    }
+
+    // Mostly from the level right below, sometimes from further below
+    Shared child(const std::vector<std::vector<Shared>>& levels, std::size_t level) {
+        const std::size_t below {m_random() % 4 == 0 ? m_random() % level : level - 1};
+
+        return levels[below][m_random() % WIDTH];
+    }
+
+    Shared fold(const Shared& node, std::unordered_map<const Node*, Shared>& folded) {
+        if (const auto iter {folded.find(node.get())}; iter != folded.end()) {
+            return iter->second;
+        }
+
+        Shared result {node};
+
+        if (node->kind == Node::Kind::Add || node->kind == Node::Kind::Mul) {
+            Shared lhs {fold(node->lhs, folded)};
+            Shared rhs {fold(node->rhs, folded)};
+
+            if (lhs->kind == Node::Kind::Number && rhs->kind == Node::Kind::Number) {
+                result = P::template make<Node>();
+                result->kind = Node::Kind::Number;
+                result->value = node->kind == Node::Kind::Add ? lhs->value + rhs->value : lhs->value * rhs->value;
+                result->value %= 1'000'003;
+            } else if (node->kind == Node::Kind::Mul && rhs->kind == Node::Kind::Number && rhs->value == 1) {
+                result = lhs;
+            } else if (node->kind == Node::Kind::Add && rhs->kind == Node::Kind::Number && rhs->value == 0) {
+                result = lhs;
+            } else if (lhs != node->lhs || rhs != node->rhs) {
+                result = P::template make<Node>();
+                result->kind = node->kind;
+                result->lhs = std::move(lhs);
+                result->rhs = std::move(rhs);
+            }
+        }
+
+        folded.emplace(node.get(), result);
+
+        return result;
+    }
+
+    long evaluate(const Shared& node, std::unordered_map<const Node*, long>& values) {
+        if (const auto iter {values.find(node.get())}; iter != values.end()) {
+            return iter->second;
+        }
+
+        long value {};
+
+        switch (node->kind) {
+            case Node::Kind::Number:
+                value = node->value;
+                break;
+            case Node::Kind::Variable:
+                value = node->value + 1;
+                break;
+            case Node::Kind::Add:
+                value = (evaluate(node->lhs, values) + evaluate(node->rhs, values)) % 1'000'003;
+                break;
+            case Node::Kind::Mul:
+                value = (evaluate(node->lhs, values) * evaluate(node->rhs, values)) % 1'000'003;
+                break;
+        }
+
+        values.emplace(node.get(), value);
+
+        return value;
+    }
+
+    std::mt19937& m_random;
+    long m_sink {};
+};
+
+// Cache of values of various sizes, which evicts the least recently used ones
+// Most requests are for a small set of hot keys; the values that are handed out are kept for a while by the
+// clients, so evicted values often outlive their entries
+template<typename P>
+class CacheWorkload {
+public:
+    explicit CacheWorkload(std::mt19937& random)
+        : m_random(random), m_in_flight(IN_FLIGHT) {}
+
+    std::size_t round() {
+        for (std::size_t i {0}; i < REQUESTS; i++) {
+            m_in_flight[i % IN_FLIGHT] = get(key());
+        }
+
+        return REQUESTS;
+    }
+private:
+    struct Value {
+        std::size_t key {};
+        std::vector<unsigned char> bytes;
+    };
+
+    using Shared = typename P::template Shared<Value>;
+
+    static constexpr std::size_t CAPACITY {20'000};
+    static constexpr std::size_t KEYS {200'000};
+    static constexpr std::size_t HOT_KEYS {10'000};
+    static constexpr std::size_t REQUESTS {500'000};
+    static constexpr std::size_t IN_FLIGHT {512};
+
+    std::size_t key() {
+        return m_random() % 10 < 8 ? m_random() % HOT_KEYS : m_random() % KEYS;
+    }
+
+    Shared get(std::size_t key) {
+        if (const auto iter {m_entries.find(key)}; iter != m_entries.end()) {
+            m_order.splice(m_order.begin(), m_order, iter->second);
+
+            return iter->second->second;
+        }
+
+        Shared value {P::template make<Value>()};
+        value->key = key;
+        value->bytes.resize(16 + m_random() % 1024);
+
+        m_order.emplace_front(key, value);
+        m_entries.emplace(key, m_order.begin());
+
+        if (m_order.size() > CAPACITY) {
+            m_entries.erase(m_order.back().first);
+            m_order.pop_back();
+        }
+
+        return value;
+    }
+
+    std::mt19937& m_random;
+    std::list<std::pair<std::size_t, Shared>> m_order;
+    std::unordered_map<std::size_t, typename std::list<std::pair<std::size_t, Shared>>::iterator> m_entries;
+    std::vector<Shared> m_in_flight;
+};
+
+// Message bus, on which every message is delivered to all the subscribers of its topic
+// Topics refer to their subscribers weakly; subscribers keep the last messages they received, and are replaced
+// by new ones every now and then
+template<typename P>
+class BusWorkload {
+public:
+    explicit BusWorkload(std::mt19937& random)
+        : m_random(random), m_topics(TOPICS) {
+        for (std::size_t i {0}; i < SUBSCRIBERS; i++) {
+            m_subscribers.push_back(subscribe());
+        }
+    }
+
+    std::size_t round() {
+        std::size_t steps {0};
+
+        for (std::size_t i {0}; i < MESSAGES; i++) {
+            steps += publish(m_random() % TOPICS);
+
+            if (i % REPLACE_EVERY == 0) {
+                m_subscribers[m_random() % SUBSCRIBERS] = subscribe();
+            }
+        }
+
+        return steps;
+    }
+private:
+    struct Message {
+        std::size_t topic {};
+        std::size_t sequence {};
+        char payload[48] {};
+    };
+
+    struct Subscriber {
+        std::deque<typename P::template Shared<Message>> inbox;
+        std::size_t received {};
+    };
+
+    static constexpr std::size_t TOPICS {256};
+    static constexpr std::size_t SUBSCRIBERS {2'000};
+    static constexpr std::size_t TOPICS_PER_SUBSCRIBER {8};
+    static constexpr std::size_t INBOX_SIZE {32};
+    static constexpr std::size_t MESSAGES {200'000};
+    static constexpr std::size_t REPLACE_EVERY {100};
+
+    typename P::template Shared<Subscriber> subscribe() {
+        auto subscriber {P::template make<Subscriber>()};
+
+        for (std::size_t i {0}; i < TOPICS_PER_SUBSCRIBER; i++) {
+            m_topics[m_random() % TOPICS].push_back(subscriber);
+        }
+
+        return subscriber;
+    }
+
+    std::size_t publish(std::size_t topic) {
+        auto message {P::template make<Message>()};
+        message->topic = topic;
+        message->sequence = m_sequence++;
+
+        auto& subscribers {m_topics[topic]};
+        std::size_t delivered {0};
+
+        for (std::size_t i {0}; i < subscribers.size();) {
+            if (const auto subscriber {subscribers[i].lock()}) {
+                subscriber->inbox.push_back(message);
+                subscriber->received++;
+
+                if (subscriber->inbox.size() > INBOX_SIZE) {
+                    subscriber->inbox.pop_front();
+                }
+
+                delivered++;
+                i++;
+            } else {
+                std::swap(subscribers[i], subscribers.back());
+                subscribers.pop_back();
+            }
+        }
+
+        return delivered;
+    }
+
+    std::mt19937& m_random;
+    std::vector<std::vector<typename P::template Weak<Subscriber>>> m_topics;
+    std::vector<typename P::template Shared<Subscriber>> m_subscribers;
+    std::size_t m_sequence {0};
+};
+
+// Peak resident set size of the process in KiB, or zero if unknown
+static std::size_t peak_rss() {
+#if defined(__APPLE__)
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return static_cast<std::size_t>(usage.ru_maxrss) / 1024;
+#elif defined(__unix__)
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    return 0;
+#endif
+}
+
+// Current resident set size of the process in KiB, or zero if unknown
+static std::size_t current_rss() {
+#if defined(__linux__)
+    std::ifstream stream {"/proc/self/statm"};
+    std::size_t size {0};
+    std::size_t resident {0};
+    stream >> size >> resident;
+
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+#else
+    return 0;
+#endif
+}
+
+template<typename W>
+static void run(std::size_t rounds, bool churn) {
+    std::mt19937 random {42};
+
+    const std::size_t allocations {g_allocations};
+    const std::size_t bytes {g_allocated_bytes};
+    const auto begin {std::chrono::steady_clock::now()};
+
+    W workload {random};
+    std::size_t steps {0};
+
+    for (std::size_t round {0}; round < rounds; round++) {
+        steps += workload.round();
+
+        // Memory that keeps growing with the same amount of live objects shows fragmentation
+        if (churn && (round + 1) % 10 == 0) {
+            std::cout << "Round " << round + 1 << ": " << current_rss() << " KiB resident, "
+                << g_allocations - g_deallocations << " live allocations\n";
+        }
+    }
+
+    const auto end {std::chrono::steady_clock::now()};
+    const double time {std::chrono::duration<double>(end - begin).count()};
+
+    std::cout << "Took " << time * 1000.0 << " ms; " << rounds << " rounds\n";
+    std::cout << "Throughput: " << static_cast<double>(steps) / time / 1e6 << " M steps/s\n";
+    std::cout << "Allocations: " << g_allocations - allocations << " ("
+        << (g_allocated_bytes - bytes) / 1024 << " KiB)\n";
+    std::cout << "Peak RSS: " << peak_rss() << " KiB\n";
+}
+
+template<typename P>
+static void run(Workload workload, bool churn) {
+    const std::size_t rounds {churn ? std::size_t(200) : std::size_t(5)};
+
+    switch (workload) {
+        case Workload::Scene:
+            run<SceneWorkload<P>>(rounds, churn);
+            break;
+        case Workload::Ast:
+            run<AstWorkload<P>>(rounds, churn);
+            break;
+        case Workload::Cache:
+            run<CacheWorkload<P>>(rounds, churn);
+            break;
+        case Workload::Bus:
+            run<BusWorkload<P>>(rounds, churn);
+            break;
+    }
+}
+
+// Each workload should be run in its own process, as the peak RSS is that of the whole process
+int main(int argc, char** argv) {
+    if (argc != 3 && argc != 4) {
+        std::cerr << "Invalid arguments\n";
+        return 1;
+    }
+
+    const char* arg {argv[1]};
+    Type type {};
+
+    if (std::strcmp(arg, "ref") == 0) {
+        type = Type::Ref;
+    } else if (std::strcmp(arg, "ptr") == 0) {
+        type = Type::Ptr;
+    } else {
+        std::cerr << "Invalid type\n";
+        return 1;
+    }
+
+    const char* workload_arg {argv[2]};
+    Workload workload {};
+
+    if (std::strcmp(workload_arg, "scene") == 0) {
+        workload = Workload::Scene;
+    } else if (std::strcmp(workload_arg, "ast") == 0) {
+        workload = Workload::Ast;
+    } else if (std::strcmp(workload_arg, "cache") == 0) {
+        workload = Workload::Cache;
+    } else if (std::strcmp(workload_arg, "bus") == 0) {
+        workload = Workload::Bus;
+    } else {
+        std::cerr << "Invalid workload\n";
+        return 1;
+    }
+
+    bool churn {false};
+
+    if (argc == 4) {
+        if (std::strcmp(argv[3], "churn") == 0) {
+            churn = true;
+        } else {
+            std::cerr << "Invalid mode\n";
+            return 1;
+        }
+    }
+
+    switch (type) {
+        case Type::Ref:
+            run<RefFamily>(workload, churn);
+            break;
+        case Type::Ptr:
+            run<PtrFamily>(workload, churn);
+            break;
+    }
+}
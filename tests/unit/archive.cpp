@@ -0,0 +1,271 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/archive.hpp>
+
+enum class Color : std::uint8_t {
+    Red,
+    Green
+};
+
+struct Node {
+    template<typename Archive>
+    void serialize(Archive& archive) {
+        archive(value, name, color, children, parent);
+    }
+
+    int value {};
+    std::string name;
+    Color color {};
+    std::vector<sm::shared_ref<Node>> children;
+    sm::weak_ref<Node> parent;
+};
+
+static sm::shared_ref<Node> make_node(int value, const sm::shared_ref<Node>& parent) {
+    sm::shared_ref<Node> node {sm::make_shared<Node>()};
+    node->value = value;
+    node->name = "node" + std::to_string(value);
+    node->color = value % 2 == 0 ? Color::Red : Color::Green;
+    node->parent = parent;
+
+    return node;
+}
+
+static sm::shared_ref<Node> make_graph() {
+    sm::shared_ref<Node> root {make_node(1, nullptr)};
+
+    for (int i {0}; i < 3; i++) {
+        root->children.push_back(make_node(i + 2, root));
+    }
+
+    // Shared subtree
+    sm::shared_ref<Node> shared {make_node(5, root)};
+    shared->children.push_back(make_node(6, shared));
+
+    root->children[0]->children.push_back(shared);
+    root->children[1]->children.push_back(shared);
+
+    return root;
+}
+
+TEST(archive, RoundTrip) {
+    std::stringstream stream;
+
+    {
+        sm::shared_ref<Node> root {make_graph()};
+        sm::archive_writer writer {stream};
+
+        writer(root, std::vector<int> {1, 2, 3}, std::vector<bool> {true, false});
+        writer.finish();
+
+        ASSERT_EQ(writer.objects(), 6u);
+    }
+
+    sm::archive_reader reader {stream};
+
+    sm::shared_ref<Node> root;
+    std::vector<int> numbers;
+    std::vector<bool> flags;
+
+    reader(root, numbers, flags);
+
+    ASSERT_EQ(reader.objects(), 6u);
+    ASSERT_EQ(numbers, (std::vector<int> {1, 2, 3}));
+    ASSERT_EQ(flags, (std::vector<bool> {true, false}));
+
+    ASSERT_EQ(root->value, 1);
+    ASSERT_EQ(root->name, "node1");
+    ASSERT_EQ(root->color, Color::Green);
+    ASSERT_TRUE(root->parent.expired());
+    ASSERT_EQ(root->children.size(), 3u);
+
+    for (const auto& child : root->children) {
+        ASSERT_EQ(child->parent.lock(), root);
+    }
+
+    // Sharing is preserved
+    const sm::shared_ref<Node>& shared {root->children[0]->children[0]};
+
+    ASSERT_EQ(shared, root->children[1]->children[0]);
+    ASSERT_EQ(shared->value, 5);
+    ASSERT_EQ(shared->children[0]->value, 6);
+    ASSERT_EQ(shared->children[0]->parent.lock(), shared);
+}
+
+TEST(archive, SharedObjectsWrittenOnce) {
+    sm::shared_ref<std::string> text {sm::make_shared<std::string>(1000, 'a')};
+
+    std::stringstream once;
+    std::stringstream twice;
+
+    {
+        sm::archive_writer writer {once};
+        writer(text);
+        writer.finish();
+    }
+
+    {
+        sm::archive_writer writer {twice};
+        writer(text, text);
+        writer.finish();
+    }
+
+    ASSERT_EQ(twice.str().size(), once.str().size() + 1);
+
+    sm::archive_reader reader {twice};
+
+    sm::shared_ref<const std::string> first;
+    sm::shared_ref<const std::string> second;
+    reader(first, second);
+
+    ASSERT_EQ(*first, *text);
+    ASSERT_EQ(first, second);
+    ASSERT_EQ(first.use_count(), 3);  // Including the reader
+}
+
+TEST(archive, NullAndExpired) {
+    std::stringstream stream;
+
+    {
+        sm::weak_ref<int> expired;
+
+        {
+            sm::shared_ref<int> p {sm::make_shared<int>(21)};
+            expired = p;
+        }
+
+        sm::archive_writer writer {stream};
+        writer(sm::shared_ref<int>(), expired);
+        writer.finish();
+    }
+
+    sm::archive_reader reader {stream};
+
+    sm::shared_ref<int> p {sm::make_shared<int>(30)};
+    sm::weak_ref<int> w {p};
+
+    reader(p, w);
+
+    ASSERT_FALSE(p);
+    ASSERT_TRUE(w.expired());
+    ASSERT_EQ(reader.objects(), 0u);
+}
+
+TEST(archive, WeakOnlyObjects) {
+    std::stringstream stream;
+    sm::shared_ref<int> p {sm::make_shared<int>(21)};
+
+    {
+        sm::archive_writer writer {stream};
+        writer(sm::weak_ref<int>(p));
+        writer.finish();
+    }
+
+    sm::weak_ref<int> w;
+
+    {
+        sm::archive_reader reader {stream};
+        reader(w);
+
+        ASSERT_EQ(*w.lock(), 21);
+    }
+
+    ASSERT_TRUE(w.expired());
+}
+
+TEST(archive, Errors) {
+    {
+        std::stringstream stream {"not an archive"};
+        ASSERT_THROW(sm::archive_reader {stream}, sm::bad_archive);
+    }
+
+    std::stringstream stream;
+
+    {
+        sm::archive_writer writer {stream};
+        sm::shared_ref<int> p {sm::make_shared<int>(21)};
+        writer(p, p, std::string("truncated"));
+        writer.finish();
+    }
+
+    std::string data {stream.str()};
+
+    {
+        std::stringstream truncated {data.substr(0, data.size() - 1)};
+        sm::archive_reader reader {truncated};
+
+        sm::shared_ref<int> p;
+        sm::shared_ref<int> p2;
+        std::string s;
+
+        ASSERT_THROW(reader(p, p2, s), sm::bad_archive);
+    }
+
+    {
+        std::stringstream mismatched {data};
+        sm::archive_reader reader {mismatched};
+
+        sm::shared_ref<int> p;
+        sm::shared_ref<long> p2;
+
+        ASSERT_THROW(reader(p, p2), sm::bad_archive);
+    }
+
+    {
+        struct Pair {
+            int first {};
+            int second {};
+        };
+
+        sm::shared_ref<Pair> pair {sm::make_shared<Pair>()};
+        sm::shared_ref<int> first {pair, &pair->first};
+        sm::shared_ref<int> second {pair, &pair->second};
+
+        std::stringstream aliasing;
+        sm::archive_writer writer {aliasing};
+
+        ASSERT_THROW(writer(first, second), sm::bad_archive);
+    }
+}
+
+TEST(archive, TrailingData) {
+    std::stringstream stream;
+
+    {
+        sm::archive_writer writer {stream};
+        writer(sm::make_shared<std::string>("archived"), 21);
+        writer.finish();
+    }
+
+    stream << "trailing";
+
+    {
+        sm::archive_reader reader {stream};
+
+        sm::shared_ref<std::string> s;
+        int i {};
+        reader(s, i);
+
+        ASSERT_EQ(*s, "archived");
+        ASSERT_EQ(i, 21);
+    }
+
+    std::string rest;
+    stream >> rest;
+
+    ASSERT_EQ(rest, "trailing");
+}
+
+TEST(archive, Unfinished) {
+    std::stringstream stream;
+
+    {
+        sm::archive_writer writer {stream};
+        writer(21);
+    }
+
+    ASSERT_TRUE(stream.str().empty());
+}
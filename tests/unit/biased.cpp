@@ -0,0 +1,141 @@
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/biased.hpp>
+
+struct Counted {
+    explicit Counted(std::atomic<int>* alive)
+        : alive(alive) {
+        (*alive)++;
+    }
+
+    ~Counted() {
+        (*alive)--;
+    }
+
+    std::atomic<int>* alive {nullptr};
+};
+
+TEST(biased_ref, OwnerThread) {
+    std::atomic<int> alive {0};
+
+    {
+        sm::biased_ref<Counted> p {sm::make_biased<Counted>(&alive)};
+
+        ASSERT_TRUE(p);
+        ASSERT_TRUE(p.owned_by_this_thread());
+        ASSERT_EQ(alive, 1);
+
+        sm::biased_ref<Counted> p2 {p};
+        sm::biased_ref<Counted> p3;
+        p3 = p2;
+
+        ASSERT_EQ(p, p3);
+
+        p.reset();
+        p2.reset();
+
+        ASSERT_FALSE(p);
+        ASSERT_EQ(alive, 1);
+    }
+
+    ASSERT_EQ(alive, 0);
+}
+
+TEST(biased_ref, SharedWithOtherThreads) {
+    std::atomic<int> alive {0};
+
+    sm::biased_ref<Counted> p {sm::make_biased<Counted>(&alive)};
+
+    std::vector<std::thread> threads;
+
+    for (int i {0}; i < 4; i++) {
+        threads.emplace_back([p]() {
+            ASSERT_FALSE(p.owned_by_this_thread());
+
+            for (int j {0}; j < 10000; j++) {
+                sm::biased_ref<Counted> copy {p};
+                ASSERT_EQ(*copy->alive, 1);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // The copies made here were released by the other threads, so the object waits for the owner to merge it
+    sm::merge_biased_refs();
+
+    ASSERT_EQ(alive, 1);
+
+    p.reset();
+
+    ASSERT_EQ(alive, 0);
+}
+
+TEST(biased_ref, LastReleaseOnOtherThread) {
+    std::atomic<int> alive {0};
+
+    sm::biased_ref<Counted> p {sm::make_biased<Counted>(&alive)};
+
+    std::thread thread {[p = std::move(p)]() mutable {
+        p.reset();
+    }};
+
+    thread.join();
+
+    ASSERT_EQ(alive, 1);
+
+    sm::merge_biased_refs();
+
+    ASSERT_EQ(alive, 0);
+}
+
+TEST(biased_ref, OwnerDroppedFirst) {
+    std::atomic<int> alive {0};
+
+    sm::biased_ref<Counted> p {sm::make_biased<Counted>(&alive)};
+    sm::biased_ref<Counted> p2 {p};
+
+    std::thread thread {[p2 = std::move(p2)]() mutable {
+        sm::biased_ref<Counted> copy {p2};
+        p2.reset();
+    }};
+
+    p.reset();
+    thread.join();
+
+    sm::merge_biased_refs();
+
+    ASSERT_EQ(alive, 0);
+}
+
+TEST(biased_ref, OwnerExited) {
+    std::atomic<int> alive {0};
+
+    sm::biased_ref<Counted> p;
+
+    std::thread thread {[&p, &alive]() {
+        p = sm::make_biased<Counted>(&alive);
+
+        sm::biased_ref<Counted> copy {p};
+    }};
+
+    thread.join();
+
+    ASSERT_FALSE(p.owned_by_this_thread());
+    ASSERT_EQ(alive, 1);
+
+    sm::biased_ref<Counted> p2 {p};
+    p.reset();
+
+    ASSERT_EQ(alive, 1);
+
+    p2.reset();
+
+    ASSERT_EQ(alive, 0);
+}
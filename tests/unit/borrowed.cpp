@@ -0,0 +1,121 @@
+#include <vector>
+#include <cstddef>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/borrowed.hpp>
+
+#include "types.hpp"
+
+struct ListNode {
+    explicit ListNode(int value)
+        : value(value) {}
+
+    int value {};
+    sm::shared_ref<ListNode> next;
+};
+
+static int sum(sm::borrowed_ref<const ListNode> node) {
+    int result {0};
+
+    while (node) {
+        result += node->value;
+        node = node->next;
+    }
+
+    return result;
+}
+
+TEST(borrowed_ref, NoCountTraffic) {
+    sm::shared_ref<ListNode> head {sm::make_shared<ListNode>(1)};
+    head->next = sm::make_shared<ListNode>(2);
+    head->next->next = sm::make_shared<ListNode>(3);
+
+    ASSERT_EQ(sum(head), 6);
+    ASSERT_EQ(head.use_count(), 1u);
+    ASSERT_EQ(head->next.use_count(), 1u);
+
+    sm::borrowed_ref<ListNode> b {head};
+
+    ASSERT_EQ(b.use_count(), 1u);
+    ASSERT_EQ(b.get(), head.get());
+    ASSERT_TRUE(b != nullptr);
+    ASSERT_TRUE(nullptr != b);
+    ASSERT_EQ((*b).value, 1);
+}
+
+TEST(borrowed_ref, ToShared) {
+    sm::shared_ref<Derived> p {sm::make_shared<Derived>()};
+    sm::borrowed_ref<Base> b {p};
+
+    ASSERT_EQ(b->x(), 30);
+
+    sm::shared_ref<Base> p2 {b.to_shared()};
+
+    ASSERT_EQ(p.use_count(), 2u);
+    ASSERT_EQ(p2.get(), p.get());
+
+    p.reset();
+
+    ASSERT_EQ(b->x(), 30);
+    ASSERT_EQ(p2.use_count(), 1u);
+}
+
+TEST(borrowed_ref, Empty) {
+    sm::borrowed_ref<int> b;
+
+    ASSERT_FALSE(b);
+    ASSERT_TRUE(b == nullptr);
+    ASSERT_TRUE(nullptr == b);
+    ASSERT_EQ(b.use_count(), 0u);
+    ASSERT_FALSE(b.to_shared());
+
+    sm::shared_ref<int> p;
+    b = p;
+
+    ASSERT_FALSE(b);
+}
+
+TEST(borrowed_ref, Immortal) {
+    static int integer {21};
+
+    sm::shared_ref<int> p {sm::shared_ref<int>::immortal(integer)};
+    sm::borrowed_ref<int> b {p};
+
+    ASSERT_EQ(b.use_count(), 1u);
+
+    sm::shared_ref<int> p2 {b.to_shared()};
+
+    ASSERT_EQ(p2.get(), &integer);
+    ASSERT_TRUE(p2.is_immortal());
+}
+
+TEST(borrowed_ref, Containers) {
+    std::vector<sm::shared_ref<int>> owners;
+
+    for (int i {0}; i < 10; i++) {
+        owners.push_back(sm::make_shared<int>(i));
+    }
+
+    std::vector<sm::borrowed_ref<int>> borrows {owners.begin(), owners.end()};
+    int total {0};
+
+    for (sm::borrowed_ref<int> b : borrows) {
+        total += *b;
+    }
+
+    ASSERT_EQ(total, 45);
+    ASSERT_EQ(owners[3].use_count(), 1u);
+}
+
+#if defined(CPP_SHARED_REF_CHECK_BORROW) && !defined(NDEBUG)
+TEST(borrowed_refDeathTest, OutlivesObject) {
+    sm::borrowed_ref<int> b;
+
+    {
+        sm::shared_ref<int> p {sm::make_shared<int>(21)};
+        b = p;
+    }
+
+    ASSERT_DEATH(static_cast<void>(*b), "borrowed_ref used after the object has been destroyed");
+}
+#endif
@@ -0,0 +1,133 @@
+#include <cstring>
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/buffer.hpp>
+
+static const char* MESSAGE = "GET /index.html HTTP/1.1";
+
+static std::string to_string(const sm::shared_slice& slice) {
+    return std::string(reinterpret_cast<const char*>(slice.data()), slice.size());
+}
+
+TEST(shared_buffer, Empty) {
+    sm::shared_buffer b;
+
+    ASSERT_FALSE(b);
+    ASSERT_TRUE(b.empty());
+    ASSERT_EQ(b.use_count(), 0);
+
+    sm::shared_slice s {b.slice()};
+
+    ASSERT_FALSE(s);
+    ASSERT_EQ(s.use_count(), 0);
+}
+
+TEST(shared_buffer, Allocation) {
+    sm::shared_buffer b {MESSAGE, std::strlen(MESSAGE)};
+
+    ASSERT_TRUE(b);
+    ASSERT_EQ(b.size(), std::strlen(MESSAGE));
+    ASSERT_EQ(b.use_count(), 1);
+    ASSERT_EQ(std::memcmp(b.data(), MESSAGE, b.size()), 0);
+
+    b[0] = std::byte {'P'};
+
+    sm::shared_buffer b2 {b};
+
+    ASSERT_EQ(b.use_count(), 2);
+    ASSERT_EQ(b2[0], std::byte {'P'});
+}
+
+TEST(shared_slice, Lifetime) {
+    sm::shared_slice s;
+
+    {
+        sm::shared_buffer b {MESSAGE, std::strlen(MESSAGE)};
+        s = b.slice(4, 11);
+
+        ASSERT_EQ(b.use_count(), 2);
+    }
+
+    ASSERT_EQ(s.use_count(), 1);
+    ASSERT_EQ(to_string(s), "/index.html");
+}
+
+TEST(shared_slice, Subslice) {
+    sm::shared_buffer b {MESSAGE, std::strlen(MESSAGE)};
+    sm::shared_slice s {b.slice()};
+
+    sm::shared_slice s2 {s.subslice(4)};
+    sm::shared_slice s3 {s2.subslice(1, 5)};
+
+    ASSERT_EQ(to_string(s2), "/index.html HTTP/1.1");
+    ASSERT_EQ(to_string(s3), "index");
+    ASSERT_EQ(s3.data(), b.data() + 5);
+    ASSERT_EQ(b.use_count(), 4);
+
+    ASSERT_TRUE(s.subslice(s.size()).empty());
+    ASSERT_THROW(s.subslice(s.size() + 1), std::out_of_range);
+    ASSERT_THROW(s.subslice(4, s.size()), std::out_of_range);
+    ASSERT_THROW(b.slice(1, b.size()), std::out_of_range);
+}
+
+TEST(shared_slice, SplitAt) {
+    sm::shared_buffer b {MESSAGE, std::strlen(MESSAGE)};
+
+    auto [method, rest] {b.slice().split_at(3)};
+
+    ASSERT_EQ(to_string(method), "GET");
+    ASSERT_EQ(to_string(rest), " /index.html HTTP/1.1");
+    ASSERT_EQ(b.use_count(), 3);
+    ASSERT_TRUE(method.adjacent_to(rest));
+    ASSERT_FALSE(rest.adjacent_to(method));
+
+    ASSERT_THROW(b.slice().split_at(b.size() + 1), std::out_of_range);
+}
+
+TEST(shared_slice, AliasingSharedRef) {
+    sm::shared_slice s;
+
+    {
+        sm::shared_ref<std::string> p {sm::make_shared<std::string>(MESSAGE)};
+        s = sm::shared_slice(p, p->data() + 4, 11);
+
+        ASSERT_EQ(p.use_count(), 2);
+    }
+
+    ASSERT_EQ(s.use_count(), 1);
+    ASSERT_EQ(to_string(s), "/index.html");
+}
+
+TEST(shared_chain, Concat) {
+    sm::shared_buffer b {MESSAGE, std::strlen(MESSAGE)};
+    sm::shared_buffer b2 {"\r\n", 2};
+
+    auto [first, second] {b.slice().split_at(4)};
+
+    sm::shared_chain c {sm::concat(first, second)};
+
+    ASSERT_EQ(c.slices().size(), 1u);
+    ASSERT_EQ(c.size(), b.size());
+
+    c.append(b2.slice());
+    c.append(sm::shared_slice());
+
+    ASSERT_EQ(c.slices().size(), 2u);
+    ASSERT_EQ(c.size(), b.size() + 2);
+    ASSERT_EQ(c.slices()[0].data(), b.data());
+
+    sm::shared_chain c2;
+    c2.append(c);
+    c2.append(c);
+
+    ASSERT_EQ(c2.slices().size(), 4u);
+    ASSERT_EQ(b.use_count(), 6);
+
+    std::string result(c.size(), '\0');
+    c.copy_to(result.data());
+
+    ASSERT_EQ(result, std::string(MESSAGE) + "\r\n");
+}
@@ -0,0 +1,144 @@
+#include <vector>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/cow.hpp>
+
+TEST(cow, CopyShares) {
+    sm::cow<std::vector<int>> c {std::vector<int> {1, 2, 3}};
+    sm::cow<std::vector<int>> c2 {c};
+
+    ASSERT_EQ(c.use_count(), 2);
+    ASSERT_EQ(&c.read(), &c2.read());
+    ASSERT_EQ(c->size(), 3u);
+    ASSERT_EQ((*c2)[1], 2);
+}
+
+TEST(cow, WriteClonesShared) {
+    sm::cow<std::vector<int>> c {std::vector<int> {1, 2, 3}};
+    sm::cow<std::vector<int>> c2 {c};
+
+    const std::vector<int>* original {&c.read()};
+
+    c2.write().push_back(4);
+
+    ASSERT_EQ(c.use_count(), 1);
+    ASSERT_EQ(c2.use_count(), 1);
+    ASSERT_EQ(&c.read(), original);
+    ASSERT_NE(&c2.read(), original);
+    ASSERT_EQ(c->size(), 3u);
+    ASSERT_EQ(c2->size(), 4u);
+
+    c2.write().push_back(5);
+
+    ASSERT_EQ(c2->size(), 5u);
+}
+
+TEST(cow, WriteUniqueInPlace) {
+    sm::cow<std::string> c {std::in_place, "hello"};
+
+    const std::string* original {&c.read()};
+
+    c.write() += ", world";
+
+    ASSERT_EQ(&c.read(), original);
+    ASSERT_EQ(*c, "hello, world");
+}
+
+TEST(cow, SnapshotShares) {
+    sm::cow<std::string> c {std::string("hello")};
+
+    sm::shared_ref<const std::string> snapshot {c.share()};
+
+    ASSERT_FALSE(c.unique());
+
+    c.write() += ", world";
+
+    ASSERT_EQ(*snapshot, "hello");
+    ASSERT_EQ(*c, "hello, world");
+    ASSERT_TRUE(c.unique());
+}
+
+TEST(cow, WriteKeepsWeakRefs) {
+    sm::cow<std::string> c {std::string("hello")};
+
+    sm::weak_ref<const std::string> w {c.observe()};
+
+    c.write() += ", world";
+
+    ASSERT_FALSE(w.expired());
+    ASSERT_EQ(*w.lock(), "hello, world");
+}
+
+TEST(cow, MakeMutDisassociatesWeakRefs) {
+    sm::cow<std::string> c {std::string("hello")};
+
+    sm::weak_ref<const std::string> w {c.observe()};
+
+    c.make_mut() += ", world";
+
+    ASSERT_TRUE(w.expired());
+    ASSERT_EQ(*c, "hello, world");
+    ASSERT_TRUE(c.unique());
+
+    const std::string* original {&c.read()};
+
+    c.make_mut() += "!";
+
+    ASSERT_EQ(&c.read(), original);
+}
+
+TEST(cow, MakeMutClonesShared) {
+    sm::cow<std::string> c {std::string("hello")};
+    sm::cow<std::string> c2 {c};
+
+    c2.make_mut() += ", world";
+
+    ASSERT_EQ(*c, "hello");
+    ASSERT_EQ(*c2, "hello, world");
+}
+
+TEST(cow, FromSharedRef) {
+    sm::shared_ref<int> p {sm::make_shared<int>(21)};
+    sm::cow<int> c {p};
+
+    ASSERT_EQ(c.use_count(), 2);
+
+    c.write() = 30;
+
+    ASSERT_EQ(*p, 21);
+    ASSERT_EQ(*c, 30);
+}
+
+TEST(cow, Swap) {
+    sm::cow<int> c {21};
+    sm::cow<int> c2 {30};
+
+    std::swap(c, c2);
+
+    ASSERT_EQ(*c, 30);
+    ASSERT_EQ(*c2, 21);
+}
+
+TEST(cow, MovedFromAssign) {
+    sm::cow<int> c {21};
+    sm::cow<int> c2 {std::move(c)};
+
+    ASSERT_EQ(*c2, 21);
+
+    c = c2;
+    c.write() = 30;
+
+    ASSERT_EQ(*c, 30);
+    ASSERT_EQ(*c2, 21);
+}
+
+#ifndef NDEBUG
+TEST(cowDeathTest, MovedFromRead) {
+    sm::cow<int> c {21};
+    sm::cow<int> c2 {std::move(c)};
+
+    ASSERT_DEATH(static_cast<void>(c.read()), "cow used after being moved from");
+}
+#endif
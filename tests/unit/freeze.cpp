@@ -0,0 +1,183 @@
+#ifdef CPP_SHARED_REF_FREEZE
+
+#include <thread>
+#include <vector>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/freeze.hpp>
+#include <cpp_shared_ref/borrowed.hpp>
+#include <cpp_shared_ref/buffer.hpp>
+
+struct Asset {
+    Asset(int value, int* alive)
+        : value(value), alive(alive) {
+        (*alive)++;
+    }
+
+    ~Asset() {
+        (*alive)--;
+    }
+
+    template<typename Visitor>
+    void visit_refs(Visitor& visitor) const {
+        for (const auto& dependency : dependencies) {
+            visitor(dependency);
+        }
+    }
+
+    int value {};
+    int* alive {nullptr};
+    std::vector<sm::shared_ref<Asset>> dependencies;
+};
+
+static sm::shared_ref<Asset> make_assets(int* alive) {
+    sm::shared_ref<Asset> root {sm::make_shared<Asset>(0, alive)};
+    sm::shared_ref<Asset> common {sm::make_shared<Asset>(100, alive)};
+
+    for (int i {1}; i <= 4; i++) {
+        sm::shared_ref<Asset> asset {sm::make_shared<Asset>(i, alive)};
+        asset->dependencies.push_back(common);
+        root->dependencies.push_back(std::move(asset));
+    }
+
+    return root;
+}
+
+static int sum(const sm::shared_ref<Asset>& asset) {
+    int result {asset->value};
+
+    for (sm::shared_ref<Asset> dependency : asset->dependencies) {
+        result += sum(dependency);
+    }
+
+    return result;
+}
+
+TEST(freeze, ReadFromThreads) {
+    int alive {0};
+
+    sm::frozen_ref<Asset> frozen {sm::freeze(make_assets(&alive))};
+
+    ASSERT_TRUE(frozen);
+    ASSERT_EQ(frozen.size(), 6u);
+    ASSERT_EQ(alive, 6);
+
+    std::vector<std::thread> threads;
+    std::vector<int> results(8);
+
+    for (std::size_t i {0}; i < results.size(); i++) {
+        threads.emplace_back([&frozen, &results, i]() {
+            for (int j {0}; j < 1000; j++) {
+                sm::shared_ref<Asset> root {frozen.get()};
+                results[i] = sum(root);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (int result : results) {
+        ASSERT_EQ(result, 410);
+    }
+
+    ASSERT_FALSE(frozen.get().unique());
+    ASSERT_EQ(frozen.get().use_count(), 1u);
+    ASSERT_EQ(frozen->dependencies[0]->dependencies[0].use_count(), 4u);
+
+    frozen = sm::frozen_ref<Asset>();
+
+    ASSERT_EQ(alive, 0);
+}
+
+TEST(freeze, BorrowedUseCount) {
+    int alive {0};
+
+    sm::frozen_ref<Asset> frozen {sm::freeze(make_assets(&alive))};
+    sm::borrowed_ref<Asset> b {frozen.get()};
+
+    ASSERT_EQ(b.use_count(), 1u);
+    ASSERT_EQ(b->dependencies.size(), 4u);
+}
+
+TEST(freeze, SliceUseCount) {
+    int alive {0};
+
+    sm::frozen_ref<Asset> frozen {sm::freeze(make_assets(&alive))};
+    sm::shared_slice s {frozen.get(), &frozen->value, sizeof(int)};
+
+    ASSERT_EQ(s.use_count(), 1u);
+    ASSERT_EQ(s.size(), sizeof(int));
+}
+
+TEST(freeze, Thaw) {
+    int alive {0};
+
+    sm::shared_ref<Asset> root {make_assets(&alive)};
+    sm::shared_ref<Asset> common {root->dependencies[0]->dependencies[0]};
+
+    sm::frozen_ref<Asset> frozen {sm::freeze(std::move(root))};
+
+    ASSERT_EQ(frozen.size(), 6u);
+    ASSERT_FALSE(common.unique());
+
+    root = sm::thaw(std::move(frozen));
+
+    ASSERT_FALSE(frozen);
+    ASSERT_TRUE(root.unique());
+    ASSERT_EQ(common.use_count(), 5u);
+
+    root.reset();
+
+    ASSERT_EQ(alive, 1);
+    ASSERT_TRUE(common.unique());
+
+    common.reset();
+
+    ASSERT_EQ(alive, 0);
+}
+
+TEST(freeze, Nested) {
+    int alive {0};
+
+    sm::shared_ref<Asset> root {make_assets(&alive)};
+    sm::shared_ref<Asset> first {root->dependencies[0]};
+
+    sm::frozen_ref<Asset> inner {sm::freeze(first)};
+
+    ASSERT_EQ(inner.size(), 2u);
+
+    {
+        sm::frozen_ref<Asset> outer {sm::freeze(root)};
+
+        ASSERT_EQ(outer.size(), 4u);
+    }
+
+    ASSERT_EQ(root.use_count(), 1u);
+    ASSERT_EQ(root->dependencies[1].use_count(), 1u);
+
+    inner = sm::frozen_ref<Asset>();
+
+    ASSERT_EQ(first.use_count(), 2u);
+
+    first.reset();
+    root.reset();
+
+    ASSERT_EQ(alive, 0);
+}
+
+TEST(freeze, WeakRefs) {
+    sm::frozen_ref<int> frozen {sm::freeze(sm::make_shared<int>(21))};
+
+    sm::weak_ref<int> w {frozen.get()};
+
+    ASSERT_FALSE(w.expired());
+    ASSERT_EQ(*w.lock(), 21);
+
+    w.reset();
+    frozen = sm::frozen_ref<int>();
+}
+
+#endif
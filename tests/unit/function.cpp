@@ -0,0 +1,96 @@
+#include <string>
+#include <memory>
+#include <functional>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/function.hpp>
+
+static int add(int a, int b) {
+    return a + b;
+}
+
+TEST(shared_function, Small) {
+    sm::shared_function<int(int, int)> function {[](int a, int b) { return a * b; }};
+
+    ASSERT_TRUE(function);
+    ASSERT_EQ(function(3, 4), 12);
+    ASSERT_EQ(function.use_count(), 0u);
+
+    sm::shared_function<int(int, int)> copy {function};
+    ASSERT_EQ(copy(5, 6), 30);
+
+    function = &add;
+    ASSERT_EQ(function(3, 4), 7);
+    ASSERT_EQ(copy(3, 4), 12);
+}
+
+TEST(shared_function, SharedClosure) {
+    std::shared_ptr<int> counter {std::make_shared<int>(0)};
+
+    sm::shared_function<int()> function {[counter, calls = 0]() mutable {
+        (*counter)++;
+        return ++calls;
+    }};
+
+    ASSERT_EQ(function.use_count(), 1u);
+    ASSERT_EQ(counter.use_count(), 2);
+
+    // The closure is not copied, and so its state is shared
+    sm::shared_function<int()> copy {function};
+    ASSERT_EQ(function.use_count(), 2u);
+    ASSERT_EQ(counter.use_count(), 2);
+
+    ASSERT_EQ(function(), 1);
+    ASSERT_EQ(copy(), 2);
+    ASSERT_EQ(*counter, 2);
+
+    sm::shared_function<int()> moved {std::move(function)};
+    ASSERT_FALSE(function);
+    ASSERT_EQ(moved.use_count(), 2u);
+
+    moved = nullptr;
+    copy = nullptr;
+    ASSERT_EQ(counter.use_count(), 1);
+}
+
+TEST(shared_function, SmallMutable) {
+    sm::shared_function<int()> function {[counter = 0]() mutable { return ++counter; }};
+
+    ASSERT_EQ(function(), 1);
+    ASSERT_EQ(function(), 2);
+
+    const sm::shared_function<int()> copy {function};
+
+    ASSERT_EQ(copy(), 3);
+    ASSERT_EQ(function(), 4);
+    ASSERT_EQ(function.use_count(), 2u);
+}
+
+TEST(shared_function, Empty) {
+    sm::shared_function<void()> function;
+
+    ASSERT_FALSE(function);
+    ASSERT_TRUE(function == nullptr);
+    ASSERT_THROW(function(), std::bad_function_call);
+}
+
+TEST(shared_function, Arguments) {
+    sm::shared_function<std::string(std::string&&, const std::string&)> function {
+        [suffix = std::string(64, '!')](std::string&& a, const std::string& b) {
+            return std::move(a) + b + suffix;
+        }
+    };
+
+    ASSERT_EQ(function("foo", "bar"), "foobar" + std::string(64, '!'));
+
+    sm::shared_function<void(int&)> increment {[](int& value) { value++; }};
+    int value {1};
+    increment(value);
+    ASSERT_EQ(value, 2);
+
+    // Copying into a std::function copies only the reference
+    std::function<std::string(std::string&&, const std::string&)> std_function {function};
+    ASSERT_EQ(function.use_count(), 2u);
+    ASSERT_EQ(std_function("a", "b"), "ab" + std::string(64, '!'));
+}
@@ -0,0 +1,211 @@
+#include <string>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/future.hpp>
+
+TEST(local_future, SetValue) {
+    sm::local_promise<int> promise;
+    sm::local_future<int> future {promise.get_future()};
+
+    ASSERT_TRUE(future.valid());
+    ASSERT_FALSE(future.ready());
+    ASSERT_THROW(future.get(), sm::bad_future);
+
+    promise.set_value(21);
+
+    ASSERT_TRUE(future.ready());
+    ASSERT_FALSE(future.has_exception());
+    ASSERT_EQ(future.get(), 21);
+    ASSERT_THROW(promise.set_value(30), sm::bad_future);
+
+    sm::local_future<int> future2 {future};
+
+    ASSERT_EQ(future2.get(), 21);
+}
+
+TEST(local_future, BrokenPromise) {
+    sm::local_future<int> future;
+
+    {
+        sm::local_promise<int> promise;
+        future = promise.get_future();
+    }
+
+    ASSERT_TRUE(future.has_exception());
+    ASSERT_THROW(future.get(), sm::broken_promise);
+}
+
+TEST(local_future, Then) {
+    sm::local_promise<int> promise;
+    int called {0};
+
+    sm::local_future<std::string> future {
+        promise.get_future()
+            .then([&called](int value) { called++; return value * 2; })
+            .then([&called](int value) { called++; return std::to_string(value); })
+    };
+
+    ASSERT_EQ(called, 0);
+
+    promise.set_value(21);
+
+    ASSERT_EQ(called, 2);
+    ASSERT_EQ(future.get(), "42");
+
+    // Attached to a ready future, the continuation is called right away
+    sm::local_future<void> future2 {future.then([&called](const std::string&) { called++; })};
+
+    ASSERT_EQ(called, 3);
+    ASSERT_TRUE(future2.ready());
+    future2.get();
+}
+
+TEST(local_future, ThenUnwrap) {
+    sm::local_promise<int> promise;
+    sm::local_promise<int> inner;
+
+    sm::local_future<int> future {
+        promise.get_future().then([&inner](int value) {
+            return inner.get_future().then([value](int inner_value) { return value + inner_value; });
+        })
+    };
+
+    promise.set_value(21);
+
+    ASSERT_FALSE(future.ready());
+
+    inner.set_value(30);
+
+    ASSERT_EQ(future.get(), 51);
+}
+
+TEST(local_future, ThenExceptions) {
+    sm::local_promise<int> promise;
+    bool called {false};
+
+    sm::local_future<int> future {promise.get_future().then([](int) -> int { throw std::runtime_error("error"); })};
+    sm::local_future<int> future2 {future.then([&called](int value) { called = true; return value; })};
+
+    promise.set_value(21);
+
+    ASSERT_THROW(future.get(), std::runtime_error);
+    ASSERT_THROW(future2.get(), std::runtime_error);
+    ASSERT_FALSE(called);
+}
+
+TEST(local_future, Cancellation) {
+    sm::local_promise<int> promise;
+    bool called {false};
+
+    {
+        sm::local_future<int> future {promise.get_future().then([&called](int value) { called = true; return value; })};
+
+        ASSERT_FALSE(promise.cancelled());
+    }
+
+    ASSERT_TRUE(promise.cancelled());
+
+    promise.set_value(21);
+
+    ASSERT_FALSE(called);
+
+    sm::local_promise<int> promise2;
+
+    ASSERT_FALSE(promise2.cancelled());
+    static_cast<void>(promise2.get_future());
+    ASSERT_TRUE(promise2.cancelled());
+    ASSERT_FALSE(promise2.get_future().valid());
+}
+
+TEST(local_future, WhenAll) {
+    std::vector<sm::local_promise<int>> promises(3);
+    std::vector<sm::local_future<int>> futures;
+
+    for (sm::local_promise<int>& promise : promises) {
+        futures.push_back(promise.get_future());
+    }
+
+    sm::local_future<std::vector<int>> all {sm::when_all(futures)};
+
+    promises[2].set_value(3);
+    promises[0].set_value(1);
+
+    ASSERT_FALSE(all.ready());
+
+    promises[1].set_value(2);
+
+    ASSERT_EQ(all.get(), (std::vector<int> {1, 2, 3}));
+    ASSERT_EQ(sm::when_all(std::vector<sm::local_future<int>>()).get().size(), 0u);
+}
+
+TEST(local_future, WhenAllTuple) {
+    sm::local_promise<int> promise;
+    sm::local_promise<std::string> promise2;
+    sm::local_promise<void> promise3;
+
+    auto all {sm::when_all(promise.get_future(), promise2.get_future(), promise3.get_future())};
+
+    promise2.set_value("S");
+    promise3.set_value();
+
+    ASSERT_FALSE(all.ready());
+
+    promise.set_value(21);
+
+    ASSERT_EQ(std::get<0>(all.get()), 21);
+    ASSERT_EQ(std::get<1>(all.get()), "S");
+}
+
+TEST(local_future, WhenAllException) {
+    std::vector<sm::local_promise<int>> promises(2);
+    std::vector<sm::local_future<int>> futures {promises[0].get_future(), promises[1].get_future()};
+
+    sm::local_future<std::vector<int>> all {sm::when_all(futures)};
+
+    promises[1].set_exception(std::make_exception_ptr(std::runtime_error("error")));
+
+    ASSERT_THROW(all.get(), std::runtime_error);
+
+    promises[0].set_value(21);
+}
+
+TEST(local_future, WhenAny) {
+    std::vector<sm::local_promise<int>> promises(3);
+    std::vector<sm::local_future<int>> futures;
+
+    for (sm::local_promise<int>& promise : promises) {
+        futures.push_back(promise.get_future());
+    }
+
+    sm::local_future<std::pair<std::size_t, int>> any {sm::when_any(futures)};
+
+    ASSERT_FALSE(any.ready());
+
+    promises[1].set_value(30);
+    promises[0].set_value(21);
+
+    ASSERT_EQ(any.get().first, 1u);
+    ASSERT_EQ(any.get().second, 30);
+}
+
+TEST(local_future, CancellationPropagates) {
+    sm::local_promise<int> promise;
+
+    sm::local_future<std::vector<int>> all {sm::when_all(std::vector {promise.get_future()})};
+
+    ASSERT_FALSE(promise.cancelled());
+
+    all = sm::local_future<std::vector<int>>();
+
+    ASSERT_TRUE(promise.cancelled());
+}
+
+TEST(local_future, MakeReadyFuture) {
+    sm::local_future<std::string> future {sm::make_ready_future<std::string>(3, 'S')};
+
+    ASSERT_EQ(future.get(), "SSS");
+}
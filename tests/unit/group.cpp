@@ -0,0 +1,86 @@
+#include <string>
+#include <vector>
+#include <tuple>
+#include <mutex>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/group.hpp>
+
+struct Mesh {
+    Mesh(std::string name, std::vector<int>& destroyed)
+        : name(std::move(name)), destroyed(destroyed) {}
+
+    ~Mesh() {
+        destroyed.push_back(0);
+    }
+
+    std::string name;
+    std::vector<int>& destroyed;
+};
+
+struct Buffer {
+    explicit Buffer(std::vector<int>& destroyed)
+        : destroyed(destroyed) {}
+
+    ~Buffer() {
+        destroyed.push_back(1);
+    }
+
+    std::vector<float> vertices;
+    std::vector<int>& destroyed;
+};
+
+struct Shareable : sm::enable_shared_from_this<Shareable> {};
+
+TEST(make_shared_group, SharedOwnership) {
+    std::vector<int> destroyed;
+
+    auto [mesh, buffer, count] {sm::make_shared_group<Mesh, Buffer, int>(
+        std::forward_as_tuple("cube", destroyed),
+        std::forward_as_tuple(destroyed),
+        std::make_tuple(8)
+    )};
+
+    ASSERT_EQ(mesh->name, "cube");
+    ASSERT_EQ(*count, 8);
+    ASSERT_EQ(mesh.use_count(), 3);
+
+    sm::weak_ref<Buffer> weak {buffer};
+
+    mesh.reset();
+    buffer.reset();
+
+    ASSERT_FALSE(weak.expired());
+    ASSERT_TRUE(destroyed.empty());
+
+    count.reset();
+
+    // In reverse order, like members
+    ASSERT_TRUE(weak.expired());
+    ASSERT_EQ(destroyed, (std::vector<int> {1, 0}));
+}
+
+TEST(make_shared_group, DefaultConstruct) {
+    auto [number, text, lock] {sm::make_shared_group<int, std::string, std::mutex>()};
+
+    ASSERT_EQ(*number, 0);
+    ASSERT_TRUE(text->empty());
+    ASSERT_TRUE(lock->try_lock());
+
+    lock->unlock();
+
+    // All of them are close together
+    const auto first {reinterpret_cast<const char*>(number.get())};
+    const auto last {reinterpret_cast<const char*>(lock.get())};
+
+    ASSERT_LT(last - first, 256);
+}
+
+TEST(make_shared_group, SharedFromThis) {
+    auto [number, shareable] {sm::make_shared_group<int, Shareable>()};
+
+    sm::shared_ref<Shareable> self {shareable->shared_from_this()};
+
+    ASSERT_EQ(self, shareable);
+    ASSERT_EQ(number.use_count(), 3);
+}
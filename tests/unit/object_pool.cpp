@@ -0,0 +1,146 @@
+#include <vector>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/object_pool.hpp>
+
+struct Message {
+    explicit Message(int* constructed)
+        : constructed(constructed) {
+        (*constructed)++;
+        buffer.reserve(1024);
+    }
+
+    ~Message() {
+        (*constructed)--;
+    }
+
+    int* constructed {nullptr};
+    std::string buffer;
+};
+
+struct ClearMessage {
+    void operator()(Message& message) const noexcept {
+        message.buffer.clear();
+    }
+};
+
+TEST(object_pool, Recycle) {
+    int constructed {0};
+
+    sm::object_pool<Message, ClearMessage> pool;
+
+    const Message* address {nullptr};
+
+    {
+        sm::shared_ref<Message> p {pool.acquire(&constructed)};
+        p->buffer = "hello";
+        address = p.get();
+
+        ASSERT_EQ(constructed, 1);
+        ASSERT_EQ(pool.in_use(), 1u);
+        ASSERT_EQ(pool.available(), 0u);
+    }
+
+    ASSERT_EQ(constructed, 1);
+    ASSERT_EQ(pool.in_use(), 0u);
+    ASSERT_EQ(pool.available(), 1u);
+
+    {
+        sm::shared_ref<Message> p {pool.acquire(&constructed)};
+        sm::shared_ref<Message> p2 {p};
+
+        ASSERT_EQ(p.get(), address);
+        ASSERT_TRUE(p->buffer.empty());
+        ASSERT_GE(p->buffer.capacity(), 1024u);
+        ASSERT_EQ(p.use_count(), 2);
+        ASSERT_EQ(constructed, 1);
+
+        sm::shared_ref<Message> p3 {pool.acquire(&constructed)};
+
+        ASSERT_NE(p3.get(), address);
+        ASSERT_EQ(constructed, 2);
+    }
+
+    ASSERT_EQ(pool.available(), 2u);
+
+    pool.shrink();
+
+    ASSERT_EQ(constructed, 0);
+}
+
+TEST(object_pool, WeakRefDelaysRecycling) {
+    int constructed {0};
+
+    sm::object_pool<Message> pool;
+    sm::weak_ref<Message> w;
+
+    {
+        sm::shared_ref<Message> p {pool.acquire(&constructed)};
+        w = p;
+    }
+
+    ASSERT_TRUE(w.expired());
+    ASSERT_EQ(pool.available(), 0u);
+
+    w.reset();
+
+    ASSERT_EQ(pool.available(), 1u);
+
+    sm::shared_ref<Message> p {pool.acquire(&constructed)};
+
+    ASSERT_EQ(p.use_count(), 1);
+    ASSERT_EQ(constructed, 1);
+}
+
+TEST(object_pool, Reserve) {
+    int constructed {0};
+
+    {
+        sm::object_pool<Message> pool;
+        pool.reserve(10, &constructed);
+
+        ASSERT_EQ(constructed, 10);
+        ASSERT_EQ(pool.available(), 10u);
+
+        std::vector<sm::shared_ref<Message>> messages;
+
+        for (int i {0}; i < 15; i++) {
+            messages.push_back(pool.acquire(&constructed));
+        }
+
+        ASSERT_EQ(constructed, 15);
+        ASSERT_EQ(pool.available(), 0u);
+        ASSERT_EQ(pool.in_use(), 15u);
+    }
+
+    ASSERT_EQ(constructed, 0);
+}
+
+TEST(object_pool, OutlivesPool) {
+    int constructed {0};
+
+    sm::shared_ref<Message> p;
+    sm::weak_ref<Message> w;
+
+    {
+        sm::object_pool<Message> pool;
+        pool.reserve(2, &constructed);
+
+        p = pool.acquire(&constructed);
+
+        sm::shared_ref<Message> p2 {pool.acquire(&constructed)};
+        w = p2;
+    }
+
+    ASSERT_EQ(constructed, 2);
+
+    w.reset();
+
+    ASSERT_EQ(constructed, 1);
+
+    p->buffer = "still alive";
+    p.reset();
+
+    ASSERT_EQ(constructed, 0);
+}
@@ -0,0 +1,249 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/persistent_map.hpp>
+
+// Hash with a lot of collisions, so that every kind of node gets used
+struct BadHash {
+    std::size_t operator()(int key) const noexcept {
+        return static_cast<std::size_t>(key % 7);
+    }
+};
+
+struct Diff {
+    std::map<int, int> added;
+    std::map<int, int> removed;
+    std::map<int, std::pair<int, int>> changed;
+};
+
+template<typename Map>
+static Diff compute_diff(const Map& from, const Map& to) {
+    Diff result;
+
+    diff(
+        from,
+        to,
+        [&](int key, int value) { result.added[key] = value; },
+        [&](int key, int value) { result.removed[key] = value; },
+        [&](int key, int old_value, int new_value) { result.changed[key] = std::make_pair(old_value, new_value); }
+    );
+
+    return result;
+}
+
+TEST(persistent_map, Empty) {
+    sm::persistent_map<int, int> m;
+
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(m.find(21), nullptr);
+    ASSERT_THROW(m.at(21), std::out_of_range);
+    ASSERT_TRUE(m.erase(21).empty());
+}
+
+TEST(persistent_map, InsertVersions) {
+    std::vector<sm::persistent_map<int, int>> versions {sm::persistent_map<int, int>()};
+
+    for (int i {0}; i < 3000; i++) {
+        versions.push_back(versions.back().insert(i, i * 2));
+    }
+
+    for (std::size_t i {0}; i < versions.size(); i++) {
+        ASSERT_EQ(versions[i].size(), i);
+
+        for (int j {0}; j < 3000; j += 97) {
+            ASSERT_EQ(versions[i].contains(j), static_cast<std::size_t>(j) < i);
+        }
+    }
+
+    ASSERT_EQ(versions.back().at(1234), 2468);
+}
+
+TEST(persistent_map, Replace) {
+    const sm::persistent_map<std::string, int> m {sm::persistent_map<std::string, int>().insert("a", 1).insert("b", 2)};
+    const sm::persistent_map<std::string, int> m2 {m.insert("a", 3)};
+
+    ASSERT_EQ(m.size(), 2u);
+    ASSERT_EQ(m2.size(), 2u);
+    ASSERT_EQ(m.at("a"), 1);
+    ASSERT_EQ(m2.at("a"), 3);
+}
+
+TEST(persistent_map, Erase) {
+    sm::transient_map<int, int> t;
+
+    for (int i {0}; i < 5000; i++) {
+        t.insert(i, i);
+    }
+
+    const sm::persistent_map<int, int> m {t.persistent()};
+    sm::persistent_map<int, int> m2 {m};
+
+    for (int i {0}; i < 5000; i += 2) {
+        m2 = m2.erase(i);
+    }
+
+    ASSERT_EQ(m.size(), 5000u);
+    ASSERT_EQ(m2.size(), 2500u);
+
+    for (int i {0}; i < 5000; i++) {
+        ASSERT_TRUE(m.contains(i));
+        ASSERT_EQ(m2.contains(i), i % 2 == 1);
+    }
+
+    ASSERT_EQ(m2.erase(0).size(), 2500u);
+}
+
+TEST(persistent_map, Collisions) {
+    sm::persistent_map<int, int, BadHash> m;
+
+    for (int i {0}; i < 200; i++) {
+        m = m.insert(i, i);
+    }
+
+    const sm::persistent_map<int, int, BadHash> m2 {m.erase(7).erase(8).insert(0, -1)};
+
+    ASSERT_EQ(m.size(), 200u);
+    ASSERT_EQ(m2.size(), 198u);
+    ASSERT_FALSE(m2.contains(7));
+    ASSERT_FALSE(m2.contains(8));
+    ASSERT_EQ(m2.at(0), -1);
+    ASSERT_EQ(m.at(0), 0);
+
+    const Diff d {compute_diff(m, m2)};
+
+    ASSERT_TRUE(d.added.empty());
+    ASSERT_EQ(d.removed.size(), 2u);
+    ASSERT_EQ(d.changed.size(), 1u);
+    ASSERT_EQ(d.changed.at(0), std::make_pair(0, -1));
+}
+
+TEST(persistent_map, Transient) {
+    const sm::persistent_map<int, int> m {sm::persistent_map<int, int>().insert(1, 1)};
+
+    sm::transient_map<int, int> t {m.transient()};
+
+    for (int i {2}; i < 1000; i++) {
+        t.insert(i, i);
+    }
+
+    t.erase(1);
+
+    const sm::persistent_map<int, int> m2 {t.persistent()};
+
+    t.insert(1000, 1000);
+
+    ASSERT_EQ(m.size(), 1u);
+    ASSERT_EQ(m2.size(), 998u);
+    ASSERT_EQ(t.size(), 999u);
+    ASSERT_FALSE(m2.contains(1000));
+    ASSERT_TRUE(m.contains(1));
+}
+
+TEST(persistent_map, ForEach) {
+    sm::persistent_map<int, int> m;
+
+    for (int i {0}; i < 1000; i++) {
+        m = m.insert(i, i);
+    }
+
+    std::unordered_map<int, int> visited;
+
+    m.for_each([&](int key, int value) {
+        visited[key] = value;
+    });
+
+    ASSERT_EQ(visited.size(), 1000u);
+    ASSERT_EQ(visited.at(999), 999);
+}
+
+TEST(persistent_map, Diff) {
+    sm::transient_map<int, int> t;
+
+    for (int i {0}; i < 10'000; i++) {
+        t.insert(i, i);
+    }
+
+    const sm::persistent_map<int, int> m {t.persistent()};
+    const sm::persistent_map<int, int> m2 {m.insert(20'000, 1).erase(5).insert(6, 60).insert(7, 7)};
+
+    ASSERT_TRUE(compute_diff(m, m).added.empty());
+
+    const Diff d {compute_diff(m, m2)};
+
+    ASSERT_EQ(d.added, (std::map<int, int> {{20'000, 1}}));
+    ASSERT_EQ(d.removed, (std::map<int, int> {{5, 5}}));
+    ASSERT_EQ(d.changed.size(), 1u);
+    ASSERT_EQ(d.changed.at(6), std::make_pair(6, 60));
+
+    const Diff d2 {compute_diff(sm::persistent_map<int, int>(), m2)};
+
+    ASSERT_EQ(d2.added.size(), m2.size());
+
+    const Diff d3 {compute_diff(m2, sm::persistent_map<int, int>())};
+
+    ASSERT_EQ(d3.removed.size(), m2.size());
+}
+
+TEST(persistent_map, DiffRandom) {
+    std::map<int, int> reference;
+    sm::persistent_map<int, int, BadHash> m;
+
+    unsigned int seed {21};
+
+    auto random {[&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<int>((seed >> 16) % 300);
+    }};
+
+    for (int i {0}; i < 200; i++) {
+        const int key {random()};
+
+        reference[key] = key;
+        m = m.insert(key, key);
+    }
+
+    std::map<int, int> reference2 {reference};
+    sm::persistent_map<int, int, BadHash> m2 {m};
+
+    for (int i {0}; i < 100; i++) {
+        const int key {random()};
+
+        if (i % 3 == 0) {
+            reference2.erase(key);
+            m2 = m2.erase(key);
+        } else {
+            reference2[key] = i;
+            m2 = m2.insert(key, i);
+        }
+    }
+
+    Diff expected;
+
+    for (const auto& [key, value] : reference) {
+        const auto iter {reference2.find(key)};
+
+        if (iter == reference2.end()) {
+            expected.removed[key] = value;
+        } else if (iter->second != value) {
+            expected.changed[key] = std::make_pair(value, iter->second);
+        }
+    }
+
+    for (const auto& [key, value] : reference2) {
+        if (reference.find(key) == reference.end()) {
+            expected.added[key] = value;
+        }
+    }
+
+    const Diff d {compute_diff(m, m2)};
+
+    ASSERT_EQ(m2.size(), reference2.size());
+    ASSERT_EQ(d.added, expected.added);
+    ASSERT_EQ(d.removed, expected.removed);
+    ASSERT_EQ(d.changed, expected.changed);
+}
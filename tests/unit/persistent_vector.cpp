@@ -0,0 +1,169 @@
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/persistent_vector.hpp>
+
+template<typename T>
+static void assert_range(const sm::persistent_vector<T>& v, T first, std::size_t count) {
+    ASSERT_EQ(v.size(), count);
+
+    for (std::size_t i {0}; i < count; i++) {
+        ASSERT_EQ(v[i], first + static_cast<T>(i));
+    }
+}
+
+static sm::persistent_vector<int> make_range(int count) {
+    sm::transient_vector<int> t;
+
+    for (int i {0}; i < count; i++) {
+        t.push_back(i);
+    }
+
+    return t.persistent();
+}
+
+TEST(persistent_vector, Empty) {
+    sm::persistent_vector<int> v;
+
+    ASSERT_TRUE(v.empty());
+    ASSERT_EQ(v.size(), 0u);
+    ASSERT_TRUE(v.begin() == v.end());
+    ASSERT_THROW(v.at(0), std::out_of_range);
+}
+
+TEST(persistent_vector, PushBackVersions) {
+    std::vector<sm::persistent_vector<int>> versions {sm::persistent_vector<int>()};
+
+    for (int i {0}; i < 2000; i++) {
+        versions.push_back(versions.back().push_back(i));
+    }
+
+    for (std::size_t i {0}; i < versions.size(); i++) {
+        assert_range(versions[i], 0, i);
+    }
+}
+
+TEST(persistent_vector, Set) {
+    const sm::persistent_vector<int> v {make_range(1500)};
+
+    const sm::persistent_vector<int> v2 {v.set(0, -1).set(700, -2).set(1499, -3)};
+
+    assert_range(v, 0, 1500);
+
+    ASSERT_EQ(v2[0], -1);
+    ASSERT_EQ(v2[700], -2);
+    ASSERT_EQ(v2[1499], -3);
+    ASSERT_EQ(v2[1], 1);
+    ASSERT_EQ(v2[1498], 1498);
+
+    ASSERT_THROW(v.set(1500, 0), std::out_of_range);
+}
+
+TEST(persistent_vector, Slice) {
+    const sm::persistent_vector<int> v {make_range(40'000)};
+
+    for (auto [begin, end] : std::vector<std::pair<std::size_t, std::size_t>> {
+        {0, 40'000}, {0, 1}, {0, 32}, {0, 33}, {1, 40'000}, {31, 1057}, {1024, 1025},
+        {39'990, 40'000}, {5000, 33'000}, {32'768, 40'000}, {100, 100}
+    }) {
+        const sm::persistent_vector<int> s {v.slice(begin, end)};
+
+        assert_range(s, static_cast<int>(begin), end - begin);
+
+        // Slices stay usable as regular vectors
+        const sm::persistent_vector<int> s2 {s.push_back(-1)};
+
+        ASSERT_EQ(s2.size(), end - begin + 1);
+        ASSERT_EQ(s2[end - begin], -1);
+        ASSERT_EQ(s2.set(0, -2)[0], -2);
+
+        if (end - begin > 2) {
+            assert_range(s2.slice(1, end - begin), static_cast<int>(begin) + 1, end - begin - 1);
+        }
+    }
+
+    assert_range(v, 0, 40'000);
+
+    ASSERT_THROW(v.slice(2, 1), std::out_of_range);
+    ASSERT_THROW(v.slice(0, 40'001), std::out_of_range);
+}
+
+TEST(persistent_vector, SliceRepeated) {
+    sm::persistent_vector<int> v {make_range(5000)};
+
+    int first {0};
+
+    while (v.size() > 3) {
+        const sm::persistent_vector<int> v2 {v.slice(2, v.size() - 1).push_back(-1)};
+        v = v2.slice(0, v2.size() - 1);
+        first += 2;
+
+        assert_range(v, first, v.size());
+    }
+}
+
+TEST(persistent_vector, Transient) {
+    const sm::persistent_vector<int> v {make_range(100)};
+
+    sm::transient_vector<int> t {v.transient()};
+
+    for (int i {100}; i < 3000; i++) {
+        t.push_back(i);
+    }
+
+    t.set(5, -5);
+
+    const sm::persistent_vector<int> v2 {t.persistent()};
+
+    t.set(6, -6);
+    t.push_back(3000);
+
+    assert_range(v, 0, 100);
+
+    ASSERT_EQ(v2.size(), 3000u);
+    ASSERT_EQ(v2[5], -5);
+    ASSERT_EQ(v2[6], 6);
+    ASSERT_EQ(v2[2999], 2999);
+
+    ASSERT_EQ(t.size(), 3001u);
+    ASSERT_EQ(t[6], -6);
+}
+
+TEST(persistent_vector, Iteration) {
+    const sm::persistent_vector<std::string> v {
+        sm::persistent_vector<std::string>().push_back("a").push_back("b").push_back("c")
+    };
+
+    std::string result;
+
+    for (const std::string& element : v) {
+        result += element;
+    }
+
+    ASSERT_EQ(result, "abc");
+    ASSERT_EQ(v.begin()->size(), 1u);
+}
+
+TEST(persistent_vector, ElementLifetime) {
+    sm::weak_ref<int> w;
+
+    {
+        sm::shared_ref<int> p {sm::make_shared<int>(21)};
+        w = p;
+
+        sm::persistent_vector<sm::shared_ref<int>> v;
+
+        for (int i {0}; i < 100; i++) {
+            v = v.push_back(p);
+        }
+
+        const auto v2 {v.slice(64, 80)};
+
+        ASSERT_EQ(p.use_count(), 117);
+    }
+
+    ASSERT_TRUE(w.expired());
+}
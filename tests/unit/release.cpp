@@ -0,0 +1,103 @@
+#include <vector>
+#include <list>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/release.hpp>
+
+struct Tracked {
+    explicit Tracked(int& destroyed)
+        : destroyed(destroyed) {}
+
+    ~Tracked() {
+        destroyed++;
+    }
+
+    int& destroyed;
+};
+
+TEST(release_all, ReleaseVector) {
+    int destroyed {0};
+
+    std::vector<sm::shared_ref<Tracked>> refs;
+
+    for (int i {0}; i < 1000; i++) {
+        refs.push_back(sm::make_shared<Tracked>(destroyed));
+    }
+
+    // Some are shared, some are referenced twice and some are empty
+    sm::shared_ref<Tracked> kept {refs[500]};
+    sm::weak_ref<Tracked> weak {refs[600]};
+    refs.push_back(refs[700]);
+    refs.push_back(nullptr);
+
+    sm::release_all(refs.begin(), refs.end());
+
+    for (const auto& ref : refs) {
+        ASSERT_FALSE(ref);
+    }
+
+    ASSERT_EQ(destroyed, 999);
+    ASSERT_EQ(kept.use_count(), 1);
+    ASSERT_TRUE(weak.expired());
+}
+
+TEST(release_all, ReleaseChains) {
+    struct Link {
+        sm::shared_ref<Link> next;
+    };
+
+    std::list<sm::shared_ref<Link>> refs;
+
+    // Destroying one object releases the next one
+    for (int i {0}; i < 300; i++) {
+        sm::shared_ref<Link> link {sm::make_shared<Link>()};
+        link->next = sm::make_shared<Link>();
+
+        sm::weak_ref<Link> next {link->next};
+        refs.push_back(std::move(link));
+    }
+
+    sm::weak_ref<Link> weak {refs.back()->next};
+
+    sm::release_all(refs.begin(), refs.end());
+
+    ASSERT_FALSE(refs.front());
+    ASSERT_TRUE(weak.expired());
+}
+
+TEST(release_all, DestructionOrder) {
+    struct Logged {
+        Logged(int id, std::vector<int>& log, const sm::shared_ref<Logged>* next_ref)
+            : id(id), log(log), next_ref(next_ref) {}
+
+        ~Logged() {
+            log.push_back(id);
+
+            // The next ref is released before this object is destroyed, but its object is not destroyed yet
+            if (next_ref != nullptr) {
+                EXPECT_FALSE(*next_ref);
+                EXPECT_TRUE(next.expired());
+                EXPECT_EQ(log.size(), static_cast<std::size_t>(id + 1));
+            }
+        }
+
+        int id;
+        std::vector<int>& log;
+        const sm::shared_ref<Logged>* next_ref;
+        sm::weak_ref<Logged> next;
+    };
+
+    std::vector<int> log;
+    std::vector<sm::shared_ref<Logged>> refs(3);
+
+    for (int i {0}; i < 3; i++) {
+        refs[i] = sm::make_shared<Logged>(i, log, i < 2 ? &refs[i + 1] : nullptr);
+    }
+
+    refs[0]->next = refs[1];
+    refs[1]->next = refs[2];
+
+    sm::release_all(refs.begin(), refs.end());
+
+    ASSERT_EQ(log, (std::vector<int> {0, 1, 2}));
+}
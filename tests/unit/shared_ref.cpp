@@ -4,6 +4,8 @@
 #include <cstdlib>
 #include <functional>
 #include <memory>
+#include <cstdint>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <cpp_shared_ref/memory.hpp>
@@ -322,6 +324,7 @@ TEST(shared_ref, Casts) {
         ASSERT_EQ(p2.use_count(), 2);
     }
 
+#if defined(__GXX_RTTI) || defined(_CPPRTTI)
     {
         sm::shared_ref<Derived2> p {sm::make_shared<Derived2>()};
         sm::shared_ref<Base> p2 {sm::static_ref_cast<Base>(p)};
@@ -346,6 +349,7 @@ TEST(shared_ref, Casts) {
         ASSERT_EQ(p2.use_count(), 3);
         ASSERT_EQ(p3.use_count(), 3);
     }
+#endif
 
     {
         sm::shared_ref<Foo> p {sm::make_shared<Foo>()};
@@ -417,6 +421,22 @@ TEST(shared_ref, GetDeleter) {
 
         ASSERT_EQ(deleter, nullptr);
     }
+
+    {
+        struct Del {
+            void operator()(int* i) const noexcept {
+                std::free(i);
+            }
+        };
+
+        int* pi {static_cast<int*>(std::malloc(sizeof(int)))};
+
+        sm::shared_ref<int> p {pi, Del()};
+
+        ASSERT_NE(sm::get_deleter<Del>(p), nullptr);
+        ASSERT_NE(sm::get_deleter<const Del>(p), nullptr);
+        ASSERT_EQ(sm::get_deleter<void(*)(int*)>(p), nullptr);
+    }
 }
 
 TEST(shared_ref, Unique) {
@@ -482,6 +502,48 @@ TEST(shared_ref, MakeShared) {
     }
 }
 
+TEST(shared_ref, MakeSharedOverAligned) {
+    std::vector<sm::shared_ref<OverAligned>> refs;
+
+    for (int i {0}; i < 64; i++) {
+        refs.push_back(sm::make_shared<OverAligned>(i));
+    }
+
+    for (int i {0}; i < 64; i++) {
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(refs[i].get()) % alignof(OverAligned), 0u);
+        ASSERT_EQ(refs[i]->value, i);
+    }
+}
+
+TEST(shared_ref, MakeSharedAligned) {
+    {
+        sm::shared_ref<int> p {sm::make_shared_aligned<int>(21)};
+
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p.get()) % 64, 0u);
+        ASSERT_EQ(*p, 21);
+        ASSERT_EQ(p.use_count(), 1);
+    }
+
+    {
+        sm::shared_ref<OverAligned> p {sm::make_shared_aligned<OverAligned, 256>(21)};
+        sm::shared_ref<OverAligned> p2 {p};
+
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p.get()) % 256, 0u);
+        ASSERT_EQ(p->value, 21);
+        ASSERT_EQ(p.use_count(), 2);
+    }
+
+    {
+        int integer {21};
+
+        {
+            sm::shared_ref<NeedsDeletion> p {sm::make_shared_aligned<NeedsDeletion>(&integer)};
+        }
+
+        ASSERT_EQ(integer, 0);
+    }
+}
+
 TEST(shared_ref, IncompleteType) {
     sm::shared_ref<NonExisting> p;
 }
@@ -616,3 +678,66 @@ TEST(shared_ref, OwnerBefore) {
         ASSERT_TRUE(p.owner_before(p2) || p2.owner_before(p));
     }
 }
+
+TEST(shared_ref, Immortal) {
+    static Foo foo;
+
+    sm::shared_ref<Foo> p {sm::shared_ref<Foo>::immortal(foo)};
+
+    ASSERT_TRUE(p);
+    ASSERT_TRUE(p.is_immortal());
+    ASSERT_EQ(p.get(), &foo);
+    ASSERT_EQ(p.use_count(), 1u);
+    ASSERT_FALSE(p.unique());
+
+    {
+        sm::shared_ref<Foo> p2 {p};
+        sm::shared_ref<const Foo> p3 {p2};
+
+        ASSERT_TRUE(p3.is_immortal());
+        ASSERT_EQ(p3->bar(), 21);
+    }
+
+    ASSERT_EQ(p->c, 'S');
+    ASSERT_FALSE(sm::shared_ref<int>().is_immortal());
+    ASSERT_FALSE(sm::make_shared<int>().is_immortal());
+}
+
+TEST(shared_ref, ImmortalAliasingEmpty) {
+    static int integer {21};
+
+    sm::shared_ref<int> empty;
+    sm::shared_ref<int> p {empty, &integer};
+
+    ASSERT_FALSE(p.is_immortal());
+    ASSERT_EQ(p.use_count(), 0u);
+
+    sm::weak_ref<int> w {p};
+
+    ASSERT_TRUE(w.expired());
+    ASSERT_FALSE(w.lock());
+
+    // Aliasing an immortal ref keeps it immortal
+    sm::shared_ref<int> immortal {sm::shared_ref<int>::immortal(integer)};
+    sm::shared_ref<const int> alias {immortal, &integer};
+
+    ASSERT_TRUE(alias.is_immortal());
+}
+
+TEST(shared_ref, MakeImmortal) {
+    int integer {21};
+
+    {
+        sm::shared_ref<NeedsDeletion> p {sm::make_immortal<NeedsDeletion>(&integer)};
+        sm::shared_ref<NeedsDeletion> p2 {p};
+
+        ASSERT_TRUE(p2.is_immortal());
+    }
+
+    ASSERT_EQ(integer, 21);
+
+    sm::shared_ref<Ints> p {sm::make_immortal<Ints>(21, 30)};
+
+    ASSERT_EQ(p->a, 21);
+    ASSERT_EQ(p->b, 30);
+}
@@ -0,0 +1,129 @@
+#include <utility>
+#include <vector>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/shared_ref_nn.hpp>
+
+struct NnBase {
+    virtual ~NnBase() = default;
+
+    int value {};
+};
+
+struct NnDerived : NnBase {
+    explicit NnDerived(int value, int& destroyed)
+        : destroyed(destroyed) {
+        this->value = value;
+    }
+
+    ~NnDerived() override {
+        destroyed++;
+    }
+
+    int& destroyed;
+};
+
+TEST(shared_ref_nn, Make) {
+    int destroyed {0};
+
+    {
+        sm::shared_ref_nn<NnDerived> ref {sm::make_shared_nn<NnDerived>(5, destroyed)};
+
+        ASSERT_EQ(ref->value, 5);
+        ASSERT_EQ((*ref).value, 5);
+        ASSERT_TRUE(ref);
+        ASSERT_TRUE(ref.unique());
+
+        sm::shared_ref_nn<NnDerived> copy {ref};
+        ASSERT_EQ(ref.use_count(), 2u);
+        ASSERT_EQ(copy, ref);
+
+        sm::shared_ref_nn<NnBase> base {copy};
+        ASSERT_EQ(ref.use_count(), 3u);
+        ASSERT_EQ(base->value, 5);
+    }
+
+    ASSERT_EQ(destroyed, 1);
+}
+
+TEST(shared_ref_nn, CheckedConversion) {
+    int destroyed {0};
+
+    sm::shared_ref<NnDerived> ref {sm::make_shared<NnDerived>(1, destroyed)};
+
+    sm::shared_ref_nn<NnDerived> shared {ref};
+    ASSERT_EQ(ref.use_count(), 2u);
+    ASSERT_EQ(shared, ref);
+
+    sm::shared_ref_nn<NnBase> moved {std::move(ref)};
+    ASSERT_FALSE(ref);
+    ASSERT_EQ(moved.use_count(), 2u);
+
+    sm::shared_ref<int> null;
+    ASSERT_THROW(sm::shared_ref_nn<int> {null}, sm::bad_null_ref);
+    ASSERT_THROW(sm::shared_ref_nn<int>(sm::shared_ref<int>()), sm::bad_null_ref);
+
+    // Aliasing references to null don't point to anything
+    const sm::shared_ref<NnBase> owner {moved};
+    ASSERT_THROW(sm::shared_ref_nn<int>(sm::shared_ref<int>(owner, nullptr)), sm::bad_null_ref);
+
+    // Aliasing references made from an empty one own nothing
+    static int object {0};
+    ASSERT_THROW(sm::shared_ref_nn<int>(sm::shared_ref<int>(null, &object)), sm::bad_null_ref);
+
+    // Immortal references have a block, which is never counted
+    sm::shared_ref_nn<int> immortal {sm::shared_ref<int>::immortal(object)};
+    sm::shared_ref_nn<int> copy {immortal};
+    ASSERT_EQ(copy.get(), &object);
+    ASSERT_EQ(copy.use_count(), 1u);
+}
+
+TEST(shared_ref_nn, Move) {
+    int destroyed {0};
+
+    sm::shared_ref_nn<NnDerived> first {sm::make_shared_nn<NnDerived>(1, destroyed)};
+    sm::shared_ref_nn<NnDerived> second {sm::make_shared_nn<NnDerived>(2, destroyed)};
+
+    // The source keeps its reference until it's destroyed
+    sm::shared_ref_nn<NnDerived> moved {std::move(first)};
+    ASSERT_EQ(moved.use_count(), 2u);
+
+    // The source gets the old reference
+    moved = std::move(second);
+    ASSERT_EQ(moved->value, 2);
+    ASSERT_EQ(second->value, 1);
+    ASSERT_EQ(destroyed, 0);
+
+    moved = moved;
+    ASSERT_EQ(moved.use_count(), 1u);
+
+    std::vector<sm::shared_ref_nn<NnDerived>> refs;
+
+    for (int i {0}; i < 100; i++) {
+        refs.push_back(moved);
+    }
+
+    ASSERT_EQ(moved.use_count(), 101u);
+
+    refs.clear();
+    first = second;
+    ASSERT_EQ(destroyed, 0);
+}
+
+TEST(shared_ref_nn, SharedAndWeak) {
+    int destroyed {0};
+
+    sm::shared_ref_nn<NnDerived> ref {sm::make_shared_nn<NnDerived>(3, destroyed)};
+
+    sm::shared_ref<NnDerived> shared {ref};
+    sm::shared_ref<NnBase> base = ref;
+    sm::weak_ref<NnDerived> weak {ref};
+
+    ASSERT_EQ(ref.use_count(), 3u);
+    ASSERT_EQ(weak.lock(), ref);
+
+    std::unordered_set<sm::shared_ref_nn<NnDerived>> set;
+    set.insert(ref);
+    ASSERT_EQ(set.count(ref), 1u);
+}
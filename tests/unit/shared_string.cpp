@@ -0,0 +1,84 @@
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <unordered_set>
+#include <functional>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/shared_string.hpp>
+
+TEST(shared_string, Small) {
+    sm::shared_string empty;
+
+    ASSERT_TRUE(empty.empty());
+    ASSERT_STREQ(empty.c_str(), "");
+
+    sm::shared_string s {"hello"};
+    sm::shared_string s2 {s};
+
+    ASSERT_EQ(s.size(), 5u);
+    ASSERT_EQ(s, "hello");
+    ASSERT_EQ(s, s2);
+    ASSERT_NE(s.data(), s2.data());  // Copied inline
+
+    // The longest small string is null-terminated by its tag
+    sm::shared_string full {std::string(sizeof(void*) * 3 - 1, 'a')};
+
+    ASSERT_EQ(full.size(), sizeof(void*) * 3 - 1);
+    ASSERT_EQ(std::string(full.c_str()), std::string(sizeof(void*) * 3 - 1, 'a'));
+}
+
+TEST(shared_string, Large) {
+    const std::string text {"This string is too long to be stored inline"};
+
+    sm::shared_string s {text};
+    sm::shared_string s2 {s};
+
+    ASSERT_EQ(s.view(), text);
+    ASSERT_STREQ(s.c_str(), text.c_str());
+    ASSERT_EQ(s.data(), s2.data());  // Shared
+
+    sm::shared_string s3 {std::move(s2)};
+
+    ASSERT_TRUE(s2.empty());
+    ASSERT_EQ(s3, s);
+
+    s = sm::shared_string("short");
+
+    ASSERT_EQ(s, "short");
+    ASSERT_EQ(s3, text);
+    ASSERT_NE(s, s3);
+    ASSERT_LT(s3, s);
+}
+
+TEST(shared_string, Hash) {
+    const std::string text {"This string is too long to be stored inline"};
+
+    sm::shared_string small {"key"};
+    sm::shared_string large {text};
+
+    ASSERT_EQ(std::hash<sm::shared_string>()(small), std::hash<std::string_view>()("key"));
+    ASSERT_EQ(std::hash<sm::shared_string>()(large), std::hash<std::string_view>()(text));
+
+    std::unordered_set<sm::shared_string> set;
+    set.insert(small);
+    set.insert(large);
+    set.insert(sm::shared_string(text));
+
+    ASSERT_EQ(set.size(), 2u);
+    ASSERT_EQ(set.count(sm::shared_string("key")), 1u);
+}
+
+TEST(shared_string, Conversions) {
+    sm::shared_string s {"hello"};
+
+    const std::string_view view {s};
+
+    ASSERT_EQ(view, "hello");
+
+    std::ostringstream stream;
+    stream << s;
+
+    ASSERT_EQ(stream.str(), "hello");
+}
@@ -0,0 +1,150 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/signal.hpp>
+
+struct Receiver {
+    void on_event(int value) {
+        values.push_back(value);
+    }
+
+    std::vector<int> values;
+};
+
+TEST(signal, Emit) {
+    sm::signal<int> signal;
+
+    sm::shared_ref<Receiver> r {sm::make_shared<Receiver>()};
+    sm::shared_ref<Receiver> r2 {sm::make_shared<Receiver>()};
+
+    signal.connect(r, &Receiver::on_event);
+    signal.connect(r2, [](Receiver& receiver, int value) { receiver.values.push_back(value * 2); });
+
+    ASSERT_EQ(signal.size(), 2u);
+    ASSERT_EQ(r.use_count(), 1u);
+
+    signal.emit(21);
+    signal(30);
+    signal.emit_unguarded(52);
+
+    ASSERT_EQ(r->values, (std::vector<int> {21, 30, 52}));
+    ASSERT_EQ(r2->values, (std::vector<int> {42, 60, 104}));
+}
+
+TEST(signal, ExpiredReceivers) {
+    sm::signal<int> signal;
+
+    sm::shared_ref<Receiver> r {sm::make_shared<Receiver>()};
+    sm::weak_ref<Receiver> w;
+
+    {
+        sm::shared_ref<Receiver> r2 {sm::make_shared<Receiver>()};
+        w = r2;
+
+        signal.connect(r2, &Receiver::on_event);
+        signal.connect(r, &Receiver::on_event);
+    }
+
+    ASSERT_TRUE(w.expired());
+    ASSERT_EQ(signal.size(), 2u);
+
+    signal.emit(21);
+
+    ASSERT_EQ(signal.size(), 1u);
+    ASSERT_EQ(r->values, (std::vector<int> {21}));
+
+    w.reset();  // The block itself has been released by the signal
+}
+
+TEST(signal, Disconnect) {
+    sm::signal<int> signal;
+
+    sm::shared_ref<Receiver> r {sm::make_shared<Receiver>()};
+
+    const sm::connection c {signal.connect(r, &Receiver::on_event)};
+    signal.connect(r, &Receiver::on_event);
+
+    signal.emit(1);
+    signal.disconnect(c);
+    signal.emit(2);
+
+    ASSERT_EQ(r->values, (std::vector<int> {1, 1, 2}));
+
+    signal.disconnect_all();
+    signal.emit(3);
+
+    ASSERT_TRUE(signal.empty());
+    ASSERT_EQ(r->values.size(), 3u);
+}
+
+struct Reentrant {
+    sm::signal<int>* signal {nullptr};
+    sm::shared_ref<Receiver> other;
+    sm::connection self {};
+    std::vector<int> values;
+};
+
+TEST(signal, ReentrantConnectDisconnect) {
+    sm::signal<int> signal;
+
+    sm::shared_ref<Reentrant> r {sm::make_shared<Reentrant>()};
+    r->signal = &signal;
+    r->other = sm::make_shared<Receiver>();
+
+    r->self = signal.connect(r, [](Reentrant& reentrant, int value) {
+        reentrant.values.push_back(value);
+
+        if (value == 1) {
+            // Connected during emission, so called from the next one on
+            reentrant.signal->connect(reentrant.other, &Receiver::on_event);
+        } else if (value == 2) {
+            reentrant.signal->disconnect(reentrant.self);
+            reentrant.signal->emit(3);
+        }
+    });
+
+    signal.emit(1);
+
+    ASSERT_EQ(r->other->values.size(), 0u);
+
+    signal.emit(2);
+
+    ASSERT_EQ(r->values, (std::vector<int> {1, 2}));
+    ASSERT_EQ(r->other->values, (std::vector<int> {3, 2}));
+    ASSERT_EQ(signal.size(), 1u);
+}
+
+TEST(signal, ReceiverDestroyedDuringEmission) {
+    sm::signal<> signal;
+
+    sm::shared_ref<Receiver> r {sm::make_shared<Receiver>()};
+    sm::shared_ref<Receiver>* owner {&r};
+
+    signal.connect(r, [owner](Receiver& receiver) {
+        owner->reset();
+        receiver.values.push_back(21);  // Still alive, as it's locked
+    });
+
+    signal.emit();
+
+    ASSERT_FALSE(r);
+    ASSERT_EQ(signal.size(), 1u);
+
+    signal.emit();
+
+    ASSERT_TRUE(signal.empty());
+}
+
+TEST(signal, ImmortalReceiver) {
+    static Receiver receiver;
+
+    sm::signal<int> signal;
+    signal.connect(sm::shared_ref<Receiver>::immortal(receiver), &Receiver::on_event);
+
+    signal.emit(21);
+    signal.emit(30);
+
+    ASSERT_EQ(receiver.values, (std::vector<int> {21, 30}));
+    ASSERT_EQ(signal.size(), 1u);
+}
@@ -0,0 +1,104 @@
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/snapshot.hpp>
+
+struct MappedNode {
+    MappedNode() = default;
+
+    explicit MappedNode(int value)
+        : value(value) {}
+
+    int value {};
+    sm::snapshot_ptr<MappedNode> next;
+    sm::snapshot_span<MappedNode> children;
+};
+
+static std::string write_snapshot(const char* name) {
+    sm::snapshot_builder builder;
+
+    const auto children {builder.emplace_array<MappedNode>(3)};
+
+    for (int i {0}; i < 3; i++) {
+        (&builder[children])[i].value = i + 10;
+    }
+
+    const auto last {builder.emplace<MappedNode>(2)};
+    const auto root {builder.emplace<MappedNode>(1)};
+
+    builder[root].next = &builder[last];
+    builder[root].children.assign(&builder[children], 3);
+    builder[last].next = &builder[root];
+
+    const std::string path {testing::TempDir() + name};
+
+    std::ofstream stream {path, std::ios::binary};
+    builder.write(stream, root);
+
+    return path;
+}
+
+TEST(snapshot, MapAndTraverse) {
+    const std::string path {write_snapshot("snapshot_traverse.bin")};
+
+    sm::shared_ref<const MappedNode> root {sm::map_snapshot<MappedNode>(path.c_str())};
+
+    ASSERT_EQ(root->value, 1);
+    ASSERT_EQ(root->next->value, 2);
+    ASSERT_EQ(root->next->next.get(), root.get());
+    ASSERT_EQ(root->children.size(), 3u);
+
+    int sum {0};
+
+    for (const MappedNode& child : root->children) {
+        sum += child.value;
+        ASSERT_FALSE(child.next);
+    }
+
+    ASSERT_EQ(sum, 33);
+}
+
+TEST(snapshot, SharedMapping) {
+    const std::string path {write_snapshot("snapshot_shared.bin")};
+
+    sm::shared_ref<const MappedNode> root {sm::map_snapshot<MappedNode>(path.c_str())};
+    sm::shared_ref<const MappedNode> child {root, &root->children[1]};
+    sm::shared_ref<const MappedNode> last {root, root->next.get()};
+    sm::weak_ref<const MappedNode> weak {root};
+
+    ASSERT_EQ(root.use_count(), 3);
+
+    root.reset();
+
+    ASSERT_EQ(child->value, 11);
+    ASSERT_EQ(last->next->value, 1);
+    ASSERT_EQ(last.use_count(), 2);
+
+    child.reset();
+    last.reset();
+
+    ASSERT_TRUE(weak.expired());
+}
+
+TEST(snapshot, Errors) {
+    const std::string missing {testing::TempDir() + "snapshot_missing.bin"};
+
+    ASSERT_THROW(sm::map_snapshot<MappedNode>(missing.c_str()), sm::bad_snapshot);
+
+    const std::string path {testing::TempDir() + "snapshot_invalid.bin"};
+
+    {
+        std::ofstream stream {path, std::ios::binary};
+        stream << "This is not a snapshot, but it's long enough to have a header";
+    }
+
+    ASSERT_THROW(sm::map_snapshot<MappedNode>(path.c_str()), sm::bad_snapshot);
+
+    sm::snapshot_builder builder;
+    const auto root {builder.emplace<MappedNode>(1)};
+
+    std::ofstream closed;
+
+    ASSERT_THROW(builder.write(closed, root), sm::bad_snapshot);
+}
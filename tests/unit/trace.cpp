@@ -0,0 +1,205 @@
+#ifdef CPP_SHARED_REF_TRACE
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstdio>
+#include <cstddef>
+#include <set>
+#include <atomic>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/memory.hpp>
+#include <cpp_shared_ref/trace.hpp>
+
+struct TracedWidget {
+    int value {};
+};
+
+static std::string read_trace(const char* path) {
+    std::ifstream stream {path};
+    std::stringstream contents;
+    contents << stream.rdbuf();
+
+    return contents.str();
+}
+
+static std::size_t count(const std::string& string, const std::string& substring) {
+    std::size_t result {0};
+
+    std::size_t position {string.find(substring)};
+
+    while (position != std::string::npos) {
+        result++;
+        position = string.find(substring, position + 1);
+    }
+
+    return result;
+}
+
+TEST(trace, Events) {
+    const char* path {"trace_events.json"};
+
+    sm::trace::flush(path);
+    sm::trace::start();
+
+    {
+        sm::trace::mark("frame");
+
+        sm::shared_ref<TracedWidget> widget {sm::make_shared<TracedWidget>()};
+        sm::shared_ref<TracedWidget> copy {widget};
+        sm::weak_ref<TracedWidget> weak {widget};
+
+        copy.reset();
+        sm::shared_ref<TracedWidget> locked {weak.lock()};
+    }
+
+    sm::trace::stop();
+
+    // Nothing is recorded while stopped
+    sm::shared_ref<TracedWidget> untraced {sm::make_shared<TracedWidget>()};
+    sm::shared_ref<TracedWidget> untraced_copy {untraced};
+
+    sm::trace::flush(path);
+
+    const std::string trace {read_trace(path)};
+    std::remove(path);
+
+    ASSERT_EQ(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    ASSERT_EQ(count(trace, "\"name\":\"frame\""), 1u);
+    ASSERT_EQ(count(trace, "\"name\":\"create\""), 1u);
+    ASSERT_EQ(count(trace, "\"name\":\"copy\",\"cat\":\"shared_ref\""), 1u);
+    ASSERT_EQ(count(trace, "\"name\":\"copy\",\"cat\":\"weak_ref\""), 1u);
+    ASSERT_EQ(count(trace, "\"name\":\"lock\""), 1u);
+    ASSERT_EQ(count(trace, "\"name\":\"release\",\"cat\":\"shared_ref\""), 3u);
+    ASSERT_EQ(count(trace, "\"name\":\"release\",\"cat\":\"weak_ref\""), 1u);
+    ASSERT_EQ(count(trace, "\"name\":\"destroy\""), 1u);
+
+    // Every event of the block knows its type
+    ASSERT_EQ(count(trace, "\"type\":\"TracedWidget\""), 9u);
+
+    // The events are only written once
+    sm::trace::flush(path);
+    ASSERT_EQ(count(read_trace(path), "\"name\""), 0u);
+    std::remove(path);
+}
+
+TEST(trace, Threads) {
+    const char* path {"trace_threads.json"};
+
+    sm::trace::flush(path);
+    sm::trace::start();
+
+    sm::shared_ref<TracedWidget> widget {sm::make_shared<TracedWidget>()};
+
+    std::thread thread {[widget]() {
+        for (int i {0}; i < 10; i++) {
+            sm::shared_ref<TracedWidget> copy {widget};
+        }
+    }};
+
+    thread.join();
+    widget.reset();
+
+    sm::trace::stop();
+    sm::trace::flush(path);
+
+    const std::string trace {read_trace(path)};
+    std::remove(path);
+
+    ASSERT_EQ(count(trace, "\"name\":\"copy\""), 11u);
+    ASSERT_EQ(count(trace, "\"name\":\"destroy\""), 1u);
+    // Each thread has its own buffer
+    std::set<std::string> threads;
+    std::size_t position {trace.find("\"tid\":")};
+
+    while (position != std::string::npos) {
+        const std::size_t end {trace.find_first_of(",}", position)};
+        threads.insert(trace.substr(position, end - position));
+        position = trace.find("\"tid\":", end);
+    }
+
+    ASSERT_EQ(threads.size(), 2u);
+}
+
+TEST(trace, FlushWhileRecording) {
+    const char* path {"trace_flush_while_recording.json"};
+
+    sm::trace::flush(path);
+    sm::trace::start();
+
+    std::atomic<bool> done {false};
+
+    std::thread thread {[&done]() {
+        sm::shared_ref<TracedWidget> widget {sm::make_shared<TracedWidget>()};
+
+        while (!done.load(std::memory_order_relaxed)) {
+            sm::shared_ref<TracedWidget> copy {widget};
+        }
+    }};
+
+    for (int i {0}; i < 20; i++) {
+        sm::trace::flush(path);
+    }
+
+    done.store(true, std::memory_order_relaxed);
+    thread.join();
+
+    sm::trace::stop();
+    sm::trace::flush(path);
+
+    const std::string trace {read_trace(path)};
+    std::remove(path);
+
+    ASSERT_EQ(count(trace, "\"name\":\"destroy\""), 1u);
+}
+
+TEST(trace, ForgetDestroyedTypes) {
+    const char* path {"trace_forget.json"};
+
+    sm::trace::flush(path);
+
+    const std::size_t types {sm::internal::trace_registry().types.size()};
+
+    sm::trace::start();
+
+    {
+        sm::shared_ref<TracedWidget> widget {sm::make_shared<TracedWidget>()};
+        sm::shared_ref<TracedWidget> copy {widget};
+    }
+
+    sm::trace::stop();
+    sm::trace::flush(path);
+
+    const std::string trace {read_trace(path)};
+    std::remove(path);
+
+    ASSERT_EQ(count(trace, "\"type\":\"TracedWidget\""), 5u);
+    ASSERT_EQ(sm::internal::trace_registry().types.size(), types);
+}
+
+TEST(trace, Overflow) {
+    const char* path {"trace_overflow.json"};
+
+    sm::trace::flush(path);
+    sm::trace::start();
+
+    sm::shared_ref<TracedWidget> widget {sm::make_shared<TracedWidget>()};
+
+    // Only the last events are kept
+    for (std::size_t i {0}; i < sm::internal::TRACE_BUFFER_SIZE; i++) {
+        sm::shared_ref<TracedWidget> copy {widget};
+    }
+
+    sm::trace::stop();
+    sm::trace::flush(path);
+
+    const std::string trace {read_trace(path)};
+    std::remove(path);
+
+    ASSERT_EQ(count(trace, "\"name\":\"create\""), 0u);
+    ASSERT_EQ(count(trace, "\"name\""), sm::internal::TRACE_BUFFER_SIZE);
+}
+
+#endif
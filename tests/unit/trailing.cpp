@@ -0,0 +1,79 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/trailing.hpp>
+
+struct Packet {
+    Packet(sm::trailing_span<std::uint8_t> payload, std::uint16_t id, const char* data)
+        : id(id), payload(payload) {
+        std::memcpy(payload.data(), data, payload.size());
+    }
+
+    std::uint16_t id {};
+    sm::trailing_span<std::uint8_t> payload;
+};
+
+struct Names {
+    Names(sm::trailing_span<std::string> names, int& destroyed)
+        : names(names), destroyed(destroyed) {
+        for (std::size_t i {0}; i < names.size(); i++) {
+            names[i] = "name" + std::to_string(i);
+        }
+    }
+
+    ~Names() {
+        // The elements are still alive
+        destroyed += !names.empty() && names[0] == "name0" ? 1 : 0;
+    }
+
+    sm::trailing_span<std::string> names;
+    int& destroyed;
+};
+
+struct Throwing {
+    Throwing(sm::trailing_span<std::string>) {
+        throw std::runtime_error("Throwing");
+    }
+};
+
+TEST(make_shared_trailing, Packet) {
+    sm::shared_ref<Packet> packet {sm::make_shared_trailing<Packet, std::uint8_t>(5, std::uint16_t(21), "hello")};
+
+    ASSERT_EQ(packet->id, 21);
+    ASSERT_EQ(packet->payload.size(), 5u);
+    ASSERT_EQ(std::memcmp(packet->payload.data(), "hello", 5), 0);
+
+    // Right after the object
+    const auto distance {packet->payload.data() - reinterpret_cast<std::uint8_t*>(packet.get())};
+
+    ASSERT_GE(distance, static_cast<std::ptrdiff_t>(sizeof(Packet)));
+    ASSERT_LE(distance, 32);
+}
+
+TEST(make_shared_trailing, DestroyElements) {
+    int destroyed {0};
+
+    {
+        sm::shared_ref<Names> names {sm::make_shared_trailing<Names, std::string>(100, destroyed)};
+        sm::weak_ref<Names> weak {names};
+
+        ASSERT_EQ(names->names[99], "name99");
+
+        names.reset();
+
+        ASSERT_TRUE(weak.expired());
+    }
+
+    ASSERT_EQ(destroyed, 1);
+
+    sm::shared_ref<Names> empty {sm::make_shared_trailing<Names, std::string>(0, destroyed)};
+
+    ASSERT_TRUE(empty->names.empty());
+}
+
+TEST(make_shared_trailing, ThrowingConstructor) {
+    ASSERT_THROW((sm::make_shared_trailing<Throwing, std::string>(10)), std::runtime_error);
+}
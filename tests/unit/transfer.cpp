@@ -0,0 +1,120 @@
+#include <thread>
+#include <vector>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/transfer.hpp>
+
+struct Tree {
+    explicit Tree(int value)
+        : value(value) {}
+
+    template<typename Visitor>
+    void visit_refs(Visitor& visitor) const {
+        for (const auto& child : children) {
+            visitor(child);
+        }
+
+        visitor(parent);
+    }
+
+    int value {};
+    std::vector<sm::shared_ref<Tree>> children;
+    sm::weak_ref<Tree> parent;
+};
+
+static sm::shared_ref<Tree> make_tree() {
+    sm::shared_ref<Tree> root {sm::make_shared<Tree>(1)};
+
+    for (int i {0}; i < 3; i++) {
+        sm::shared_ref<Tree> child {sm::make_shared<Tree>(i)};
+        child->parent = root;
+        root->children.push_back(std::move(child));
+    }
+
+    // Shared subtree
+    root->children.push_back(root->children[0]);
+
+    return root;
+}
+
+TEST(transfer_ref, Handoff) {
+    sm::shared_ref<Tree> root {make_tree()};
+
+    sm::transfer_ref<Tree> transfer {std::move(root)};
+
+    ASSERT_FALSE(root);
+    ASSERT_TRUE(transfer);
+
+    std::thread thread {[&transfer]() {
+        sm::shared_ref<Tree> received {transfer.receive()};
+
+        for (const auto& child : received->children) {
+            child->value *= 10;
+        }
+
+        transfer = sm::transfer_ref<Tree>(std::move(received));
+    }};
+
+    thread.join();
+
+    root = transfer.receive();
+
+    ASSERT_FALSE(transfer);
+    ASSERT_EQ(root.use_count(), 1);
+    ASSERT_EQ(root->children[0]->value, 0);
+    ASSERT_EQ(root->children[1]->value, 10);
+    ASSERT_EQ(root->children[2]->value, 20);
+}
+
+TEST(transfer_ref, RejectShared) {
+    sm::shared_ref<int> p {sm::make_shared<int>(21)};
+    sm::shared_ref<int> p2 {p};
+
+    ASSERT_THROW(sm::transfer_ref<int>(std::move(p)), sm::bad_transfer_ref);
+    ASSERT_TRUE(p);
+
+    p2.reset();
+
+    sm::weak_ref<int> w {p};
+
+    ASSERT_THROW(sm::transfer_ref<int>(std::move(p)), sm::bad_transfer_ref);
+    ASSERT_TRUE(p);
+
+    w.reset();
+
+    sm::transfer_ref<int> transfer {std::move(p)};
+
+    ASSERT_EQ(*transfer.receive(), 21);
+}
+
+TEST(transfer_ref, Empty) {
+    sm::transfer_ref<int> transfer {sm::shared_ref<int>()};
+
+    ASSERT_FALSE(transfer);
+    ASSERT_FALSE(transfer.receive());
+}
+
+#ifndef NDEBUG
+TEST(transfer_ref, RejectSharedChild) {
+    sm::shared_ref<Tree> root {make_tree()};
+
+    {
+        sm::shared_ref<Tree> outside {root->children[1]};
+
+        ASSERT_THROW(sm::transfer_ref<Tree>(std::move(root)), sm::bad_transfer_ref);
+        ASSERT_TRUE(root);
+    }
+
+    {
+        sm::weak_ref<Tree> outside {root->children[2]};
+
+        ASSERT_THROW(sm::transfer_ref<Tree>(std::move(root)), sm::bad_transfer_ref);
+        ASSERT_TRUE(root);
+    }
+
+    sm::transfer_ref<Tree> transfer {std::move(root)};
+
+    ASSERT_TRUE(transfer);
+}
+#endif
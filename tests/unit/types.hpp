@@ -97,3 +97,10 @@ struct Ints {
     int a {};
     int b {};
 };
+
+struct alignas(64) OverAligned {
+    OverAligned(int value)
+        : value(value) {}
+
+    int value {};
+};
@@ -0,0 +1,94 @@
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <cpp_shared_ref/unique_ref.hpp>
+
+struct UniqueBase {
+    int value {};
+};
+
+struct UniqueDerived : UniqueBase {
+    explicit UniqueDerived(int& destroyed)
+        : destroyed(destroyed) {}
+
+    ~UniqueDerived() {
+        destroyed++;
+    }
+
+    int& destroyed;
+};
+
+struct UniqueShareable : sm::enable_shared_from_this<UniqueShareable> {
+    std::vector<int> values;
+};
+
+TEST(unique_ref, Unique) {
+    int destroyed {0};
+
+    {
+        sm::unique_ref<UniqueDerived> ref {sm::make_unique_ref<UniqueDerived>(destroyed)};
+        ref->value = 3;
+
+        ASSERT_TRUE(ref);
+        ASSERT_EQ((*ref).value, 3);
+
+        sm::unique_ref<UniqueDerived> moved {std::move(ref)};
+        ASSERT_FALSE(ref);
+        ASSERT_TRUE(ref == nullptr);
+        ASSERT_EQ(moved->value, 3);
+
+        moved.reset();
+        ASSERT_EQ(destroyed, 1);
+
+        // The object is destroyed through its block, even without a virtual destructor
+        sm::unique_ref<UniqueBase> base {sm::make_unique_ref<UniqueDerived>(destroyed)};
+        base = sm::make_unique_ref<UniqueDerived>(destroyed);
+        ASSERT_EQ(destroyed, 2);
+    }
+
+    ASSERT_EQ(destroyed, 3);
+}
+
+TEST(unique_ref, Share) {
+    int destroyed {0};
+
+    {
+        sm::unique_ref<UniqueDerived> ref {sm::make_unique_ref<UniqueDerived>(destroyed)};
+        ref->value = 5;
+
+        UniqueDerived* const object {ref.get()};
+
+        // The object stays where it is
+        sm::shared_ref<UniqueDerived> shared {std::move(ref)};
+        ASSERT_FALSE(ref);
+        ASSERT_EQ(shared.get(), object);
+        ASSERT_EQ(shared.use_count(), 1u);
+
+        sm::weak_ref<UniqueDerived> weak {shared};
+        sm::shared_ref<UniqueBase> base = sm::make_unique_ref<UniqueDerived>(destroyed);
+        ASSERT_EQ(base.use_count(), 1u);
+
+        shared.reset();
+        ASSERT_TRUE(weak.expired());
+        ASSERT_EQ(destroyed, 1);
+    }
+
+    ASSERT_EQ(destroyed, 2);
+
+    sm::shared_ref<UniqueBase> empty {sm::unique_ref<UniqueBase>()};
+    ASSERT_FALSE(empty);
+}
+
+TEST(unique_ref, SharedFromThis) {
+    sm::unique_ref<UniqueShareable> ref {sm::make_unique_ref<UniqueShareable>()};
+    ref->values.push_back(1);
+
+    // Not shared yet
+    ASSERT_TRUE(ref->weak_from_this().expired());
+    ASSERT_THROW(ref->shared_from_this(), sm::bad_weak_ref);
+
+    sm::shared_ref<UniqueShareable> shared {std::move(ref)};
+    ASSERT_EQ(shared->shared_from_this(), shared);
+    ASSERT_EQ(shared.use_count(), 1u);
+}
@@ -266,3 +266,26 @@ TEST(weak_ref, OwnerBefore) {
         ASSERT_TRUE(w.owner_before(w2) || w2.owner_before(w));
     }
 }
+
+TEST(weak_ref, Immortal) {
+    static int integer {21};
+
+    sm::weak_ref<int> w;
+
+    {
+        sm::shared_ref<int> p {sm::shared_ref<int>::immortal(integer)};
+        w = p;
+    }
+
+    ASSERT_FALSE(w.expired());
+    ASSERT_EQ(w.use_count(), 1u);
+
+    sm::shared_ref<int> p {w.lock()};
+
+    ASSERT_TRUE(p.is_immortal());
+    ASSERT_EQ(*p, 21);
+
+    sm::shared_ref<int> p2 {w};
+
+    ASSERT_EQ(p2.get(), &integer);
+}